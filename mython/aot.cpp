@@ -0,0 +1,424 @@
+#include "aot.h"
+
+#include "statement.h"
+
+#include <cstdio>
+#include <stdexcept>
+
+using namespace std;
+
+namespace aot {
+
+namespace {
+
+const string HOLDER = "runtime::ObjectHolder"s;
+const string NONE = "runtime::ObjectHolder::None()"s;
+const string FUNCTION_PARAMS
+    = "([[maybe_unused]] runtime::Closure& closure, [[maybe_unused]] runtime::Context& context)"s;
+
+}  // namespace
+
+std::string Generator::Translate(ast::Statement& program) {
+    TranslateFunction("RunProgram"s, program);
+
+    string result = "// Программа на C++, полученная трансляцией программы на Mython\n"s
+        "#include \"aot_support.h\"\n\n"s
+        "#include <iostream>\n\n"s
+        "using namespace std::literals;\n\n"s
+        "namespace {\n\n"s;
+    result += declarations_ + "\n"s;
+    result += constants_ + "\n"s;
+    result += classes_;
+    result += instances_ + "\n"s;
+    result += functions_;
+    result += "}  // namespace\n\n"s
+        "int main() {\n"s
+        "    runtime::SimpleContext context{std::cout};\n"s
+        "    runtime::Closure closure;\n"s
+        "    try {\n"s
+        "        RunProgram(closure, context);\n"s
+        "    } catch (const std::exception& e) {\n"s
+        "        std::cerr << e.what() << std::endl;\n"s
+        "        return 1;\n"s
+        "    }\n"s
+        "    return 0;\n"s
+        "}\n"s;
+    return result;
+}
+
+std::string Generator::NewTemporary() {
+    return "t"s + to_string(++temporary_count_);
+}
+
+void Generator::Line(const std::string& line) {
+    Function& function = functions_stack_.back();
+    function.text.append(static_cast<size_t>(function.indent) * 4, ' ');
+    function.text += line;
+    function.text += '\n';
+}
+
+void Generator::Open(const std::string& line) {
+    Line(line + " {"s);
+    ++functions_stack_.back().indent;
+}
+
+void Generator::Close() {
+    --functions_stack_.back().indent;
+    Line("}"s);
+}
+
+std::string Generator::AddString(const std::string& value) {
+    string name = "string"s + to_string(++constant_count_);
+    constants_ += "const "s + HOLDER + " "s + name + " = "s + HOLDER + "::Own(runtime::String("s
+        + Quote(value) + "s));\n"s;
+    return name;
+}
+
+std::string Generator::GetClass(const runtime::Class& cls) {
+    if (auto it = class_names_.find(&cls); it != class_names_.end()) {
+        return it->second;
+    }
+    const string parent
+        = cls.GetParent() ? "&"s + GetClass(*cls.GetParent()) : "nullptr"s;
+    const string name = "class"s + to_string(class_names_.size());
+    class_names_[&cls] = name;
+
+    string methods = "// class "s + cls.GetName() + "\n"s
+        "std::vector<runtime::Method> "s + name + "_methods() {\n"s
+        "    std::vector<runtime::Method> methods;\n"s;
+    const auto& class_methods = cls.GetMethods();
+    for (size_t i = 0; i < class_methods.size(); ++i) {
+        const runtime::Method& method = class_methods[i];
+        auto* body = dynamic_cast<ast::Statement*>(method.body.get());
+        if (!body || method.frame_size == 0) {
+            throw runtime_error("Method "s + cls.GetName() + "."s + method.name
+                + " cannot be translated to C++"s);
+        }
+        const string function = name + "_"s + to_string(i);
+        TranslateFunction(function, *body);
+
+        string params;
+        for (const string& param : method.formal_params) {
+            params += (params.empty() ? ""s : ", "s) + Quote(param) + "s"s;
+        }
+        methods += "    methods.push_back({"s + Quote(method.name) + "s, {"s + params
+            + "}, std::make_unique<aot::NativeMethod>(&"s + function + "), "s
+            + to_string(method.frame_size) + "});\n"s;
+    }
+    methods += "    return methods;\n}\n"s;
+    classes_ += methods + "runtime::Class "s + name + "("s + Quote(cls.GetName()) + "s, "s + name
+        + "_methods(), "s + parent + ");\n\n"s;
+    return name;
+}
+
+std::string Generator::AddInstance(const runtime::Class& cls) {
+    const string cls_name = GetClass(cls);
+    string name = "instance"s + to_string(++instance_count_);
+    instances_ += "runtime::ClassInstance "s + name + "("s + cls_name + ");\n"s;
+    return name;
+}
+
+std::string Generator::Quote(std::string_view text) {
+    string result = "\""s;
+    for (char c : text) {
+        switch (c) {
+        case '"':
+            result += "\\\""s;
+            break;
+        case '\\':
+            result += "\\\\"s;
+            break;
+        case '\n':
+            result += "\\n"s;
+            break;
+        case '\t':
+            result += "\\t"s;
+            break;
+        default:
+            if (static_cast<unsigned char>(c) < 0x20 || c == 0x7F) {
+                // Восьмеричная запись не продолжается следующими символами строки
+                char escaped[5];
+                snprintf(escaped, sizeof(escaped), "\\%03o", static_cast<unsigned char>(c));
+                result += escaped;
+            }
+            else {
+                result += c;
+            }
+        }
+    }
+    return result + "\""s;
+}
+
+void Generator::TranslateFunction(const std::string& name, ast::Statement& body) {
+    declarations_ += HOLDER + " "s + name + "(runtime::Closure& closure, runtime::Context& context);\n"s;
+    functions_stack_.push_back({});
+    Open(HOLDER + " "s + name + FUNCTION_PARAMS);
+    Line("[[maybe_unused]] runtime::FrameSlot* frame = context.GetFrame();"s);
+    body.Transpile(*this);
+    Line("return "s + NONE + ";"s);
+    Close();
+    functions_ += functions_stack_.back().text + "\n"s;
+    functions_stack_.pop_back();
+}
+
+std::string Translate(ast::Statement& program) {
+    return Generator{}.Translate(program);
+}
+
+}  // namespace aot
+
+// Трансляция узлов AST в C++
+
+namespace ast {
+
+using aot::Generator;
+
+namespace {
+
+// Сохраняет значение выражения value во временной переменной и возвращает её имя.
+// Transpile возвращает выражения без побочных эффектов, поэтому инструкция, значение
+// которой не используется, выполняется ровно один раз
+std::string Store(Generator& generator, const std::string& value) {
+    const string temporary = generator.NewTemporary();
+    generator.Line("const runtime::ObjectHolder "s + temporary + " = "s + value + ";"s);
+    return temporary;
+}
+
+// Возвращает выражение, вычисляющее значение бинарной операции function над lhs и rhs
+std::string TranspileBinary(Generator& generator, Statement& lhs, Statement& rhs,
+    const std::string& function) {
+    const string left = lhs.Transpile(generator);
+    const string right = rhs.Transpile(generator);
+    return function + "("s + left + ", "s + right + ", context)"s;
+}
+
+}  // namespace
+
+std::string Statement::Transpile([[maybe_unused]] Generator& generator) {
+    throw runtime_error("Statement cannot be translated to C++"s);
+}
+
+std::string TranspileConstant([[maybe_unused]] Generator& generator,
+    const runtime::Number& value) {
+    return "runtime::ObjectHolder::Own(runtime::Number("s + to_string(value.GetValue()) + "))"s;
+}
+
+std::string TranspileConstant([[maybe_unused]] Generator& generator,
+    const runtime::Bool& value) {
+    return value.GetValue() ? "runtime::ObjectHolder::True()"s : "runtime::ObjectHolder::False()"s;
+}
+
+std::string TranspileConstant(Generator& generator, const runtime::String& value) {
+    return generator.AddString(value.GetValue());
+}
+
+std::string None::Transpile([[maybe_unused]] Generator& generator) {
+    return "runtime::ObjectHolder::None()"s;
+}
+
+std::string VariableValue::Transpile(Generator& generator) {
+    string value = slot_ != MethodScope::NO_SLOT
+        ? "aot::LoadSlot(frame, "s + to_string(slot_) + ")"s
+        : "aot::LoadName(closure, "s + Generator::Quote(var_name_) + "s)"s;
+    for (const string& field : field_path_.GetFieldNames()) {
+        value = "aot::GetField("s + value + ", "s + Generator::Quote(field) + "s)"s;
+    }
+    return Store(generator, value);
+}
+
+std::string Assignment::Transpile(Generator& generator) {
+    const string value = rv_->Transpile(generator);
+    if (slot_ != MethodScope::NO_SLOT) {
+        generator.Line("frame["s + to_string(slot_) + "] = "s + value + ";"s);
+    }
+    else {
+        generator.Line("closure["s + Generator::Quote(var_) + "s] = "s + value + ";"s);
+    }
+    return value;
+}
+
+std::string FieldAssignment::Transpile(Generator& generator) {
+    const string object = object_.Transpile(generator);
+    const string instance = generator.NewTemporary();
+    generator.Line("runtime::ClassInstance& "s + instance + " = aot::ExpectInstance("s + object
+        + ", \"Object must be a ClassInstance to assign a field\");"s);
+    const string value = rv_->Transpile(generator);
+    generator.Line(instance + ".SetField("s + Generator::Quote(field_name_) + "s, "s + value
+        + ");"s);
+    return value;
+}
+
+std::string Print::Transpile(Generator& generator) {
+    for (size_t i = 0; i < args_.size(); ++i) {
+        if (i > 0) {
+            generator.Line("context.GetOutputStream() << ' ';"s);
+        }
+        generator.Line("aot::PrintValue("s + args_[i]->Transpile(generator) + ", context);"s);
+    }
+    generator.Line("context.GetOutputStream() << '\\n';"s);
+    return "runtime::ObjectHolder::None()"s;
+}
+
+std::string MethodCall::Transpile(Generator& generator) {
+    const string object = object_->Transpile(generator);
+    const string instance = generator.NewTemporary();
+    generator.Line("runtime::ClassInstance& "s + instance + " = aot::ExpectInstance("s + object
+        + ", \"Object must be a ClassInstance to call a method\");"s);
+    const string site = generator.NewTemporary();
+    generator.Line("static aot::CallSite "s + site + " = aot::MakeCallSite("s
+        + Generator::Quote(method_) + "s, "s + to_string(args_.size()) + ");"s);
+    const string method = generator.NewTemporary();
+    generator.Line("const runtime::Method* "s + method + " = aot::FindMethod("s + site + ", "s
+        + instance + ".GetClass());"s);
+    string args;
+    for (auto& arg : args_) {
+        args += (args.empty() ? ""s : ", "s) + arg->Transpile(generator);
+    }
+    return Store(generator,
+        "aot::Call("s + instance + ", "s + method + ", {"s + args + "}, context)"s);
+}
+
+std::string NewInstance::Transpile(Generator& generator) {
+    const string instance = generator.AddInstance(class_p_.GetClass());
+    const string init = generator.NewTemporary();
+    // Аргументы вычисляются, только если есть метод __init__ с подходящим числом параметров
+    generator.Open("if (const runtime::Method* "s + init + " = "s + instance
+        + ".GetClass().GetSpecialMethod(runtime::SpecialMethod::INIT, "s
+        + to_string(args_.size()) + "))"s);
+    string args;
+    for (auto& arg : args_) {
+        args += (args.empty() ? ""s : ", "s) + arg->Transpile(generator);
+    }
+    generator.Line(instance + ".Call(*"s + init + ", {"s + args + "}, context);"s);
+    generator.Close();
+    return "runtime::ObjectHolder::Share("s + instance + ")"s;
+}
+
+std::string Stringify::Transpile(Generator& generator) {
+    return Store(generator, "aot::Stringify("s + argument_->Transpile(generator) + ", context)"s);
+}
+
+std::string Add::Transpile(Generator& generator) {
+    return Store(generator, TranspileBinary(generator, *lhs_, *rhs_, "runtime::Add"s));
+}
+
+std::string Sub::Transpile(Generator& generator) {
+    return Store(generator, TranspileBinary(generator, *lhs_, *rhs_, "runtime::Sub"s));
+}
+
+std::string Mult::Transpile(Generator& generator) {
+    return Store(generator, TranspileBinary(generator, *lhs_, *rhs_, "runtime::Mult"s));
+}
+
+std::string Div::Transpile(Generator& generator) {
+    return Store(generator, TranspileBinary(generator, *lhs_, *rhs_, "runtime::Div"s));
+}
+
+std::string Or::Transpile(Generator& generator) {
+    const string result = generator.NewTemporary();
+    generator.Line("runtime::ObjectHolder "s + result + ";"s);
+    const string lhs = lhs_->Transpile(generator);
+    generator.Open("if (runtime::IsTrue("s + lhs + "))"s);
+    generator.Line(result + " = runtime::ObjectHolder::True();"s);
+    generator.Close();
+    generator.Open("else"s);
+    generator.Line(result + " = aot::ToBool(runtime::IsTrue("s + rhs_->Transpile(generator)
+        + "));"s);
+    generator.Close();
+    return result;
+}
+
+std::string And::Transpile(Generator& generator) {
+    const string result = generator.NewTemporary();
+    generator.Line("runtime::ObjectHolder "s + result + ";"s);
+    const string lhs = lhs_->Transpile(generator);
+    generator.Open("if (!runtime::IsTrue("s + lhs + "))"s);
+    generator.Line(result + " = runtime::ObjectHolder::False();"s);
+    generator.Close();
+    generator.Open("else"s);
+    generator.Line(result + " = aot::ToBool(runtime::IsTrue("s + rhs_->Transpile(generator)
+        + "));"s);
+    generator.Close();
+    return result;
+}
+
+std::string Not::Transpile(Generator& generator) {
+    return "aot::ToBool(!runtime::IsTrue("s + argument_->Transpile(generator) + "))"s;
+}
+
+std::string Compound::Transpile(Generator& generator) {
+    for (auto& argument : args_) {
+        argument->Transpile(generator);
+    }
+    return "runtime::ObjectHolder::None()"s;
+}
+
+std::string MethodBody::Transpile(Generator& generator) {
+    return body_->Transpile(generator);
+}
+
+std::string Return::Transpile(Generator& generator) {
+    generator.Line("return "s + statement_->Transpile(generator) + ";"s);
+    return "runtime::ObjectHolder::None()"s;
+}
+
+std::string ClassDefinition::Transpile(Generator& generator) {
+    const auto& cls = cls_.As<runtime::Class>();
+    generator.Line("closure["s + Generator::Quote(cls.GetName()) + "s] = "s
+        + "runtime::ObjectHolder::Share("s + generator.GetClass(cls) + ");"s);
+    return "runtime::ObjectHolder::None()"s;
+}
+
+std::string IfElse::Transpile(Generator& generator) {
+    const string condition = condition_->Transpile(generator);
+    generator.Open("if (runtime::IsTrue("s + condition + "))"s);
+    if_body_->Transpile(generator);
+    generator.Close();
+    if (else_body_) {
+        generator.Open("else"s);
+        else_body_->Transpile(generator);
+        generator.Close();
+    }
+    return "runtime::ObjectHolder::None()"s;
+}
+
+std::string Comparison::Transpile(Generator& generator) {
+    static const string FUNCTIONS[] = {
+        "runtime::Less"s,
+        "runtime::Greater"s,
+        "runtime::Equal"s,
+        "runtime::NotEqual"s,
+        "runtime::LessOrEqual"s,
+        "runtime::GreaterOrEqual"s,
+    };
+    if (operator_ == Operator::OTHER) {
+        return Statement::Transpile(generator);
+    }
+    return Store(generator, "aot::ToBool("s
+        + TranspileBinary(generator, *lhs_, *rhs_, FUNCTIONS[static_cast<size_t>(operator_)])
+        + ")"s);
+}
+
+std::string FieldIncrement::Transpile(Generator& generator) {
+    const string object = object_.Transpile(generator);
+    const string instance = generator.NewTemporary();
+    generator.Line("runtime::ClassInstance& "s + instance + " = aot::ExpectInstance("s + object
+        + ", \"Object must be a ClassInstance to assign a field\");"s);
+    const string value = generator.NewTemporary();
+    generator.Line("const runtime::ObjectHolder "s + value + " = aot::GetField("s + object + ", "s
+        + Generator::Quote(field_name_) + "s);"s);
+    const string increment = increment_->Transpile(generator);
+    const string result = generator.NewTemporary();
+    generator.Line("const runtime::ObjectHolder "s + result + " = runtime::Add("s + value + ", "s
+        + increment + ", context);"s);
+    generator.Line(instance + ".SetField("s + Generator::Quote(field_name_) + "s, "s + result
+        + ");"s);
+    return result;
+}
+
+std::string ReturnVariable::Transpile(Generator& generator) {
+    generator.Line("return "s + variable_.Transpile(generator) + ";"s);
+    return "runtime::ObjectHolder::None()"s;
+}
+
+}  // namespace ast
@@ -0,0 +1,77 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace ast {
+class Statement;
+}  // namespace ast
+
+namespace aot {
+
+/*
+ * Транслирует AST программы на Mython в исходный текст программы на C++.
+ * Каждый метод класса становится функцией C++, а выражения - последовательностью
+ * вызовов функций runtime. Полученная программа подключает aot_support.h, собирается
+ * вместе с runtime.cpp и выводит то же, что и интерпретатор.
+ * Узлы AST добавляют свой код методом Statement::Transpile
+ */
+class Generator {
+public:
+    // Возвращает исходный текст программы на C++, выполняющей program
+    std::string Translate(ast::Statement& program);
+
+    // Возвращает имя новой временной переменной
+    std::string NewTemporary();
+
+    // Добавляет строку кода в текущую функцию
+    void Line(const std::string& line);
+
+    // Добавляет строку кода, открывающую блок: line {
+    void Open(const std::string& line);
+
+    // Закрывает блок, открытый методом Open
+    void Close();
+
+    // Возвращает имя константы, хранящей строку value
+    std::string AddString(const std::string& value);
+
+    // Возвращает имя объекта класса cls. Методы класса транслируются при первом обращении
+    std::string GetClass(const runtime::Class& cls);
+
+    // Возвращает имя нового экземпляра класса cls, общего для всех выполнений одного узла
+    std::string AddInstance(const runtime::Class& cls);
+
+    // Возвращает строковый литерал C++ со значением text
+    static std::string Quote(std::string_view text);
+
+private:
+    // Текст функции, которая транслируется в данный момент
+    struct Function {
+        std::string text;
+        int indent = 0;
+    };
+
+    // Транслирует тело body в функцию C++ с именем name и добавляет её в программу
+    void TranslateFunction(const std::string& name, ast::Statement& body);
+
+    std::vector<Function> functions_stack_;
+    std::string declarations_;
+    std::string constants_;
+    std::string classes_;
+    std::string instances_;
+    std::string functions_;
+    std::unordered_map<const runtime::Class*, std::string> class_names_;
+    size_t temporary_count_ = 0;
+    size_t constant_count_ = 0;
+    size_t instance_count_ = 0;
+};
+
+// Возвращает исходный текст программы на C++, выполняющей program
+std::string Translate(ast::Statement& program);
+
+}  // namespace aot
@@ -0,0 +1,134 @@
+#pragma once
+
+/*
+ * Небольшая библиотека поддержки для программ, полученных трансляцией Mython в C++ (aot.h).
+ * Сгенерированная программа подключает этот заголовок и собирается вместе с runtime.cpp
+ */
+
+#include "call_site.h"
+#include "runtime.h"
+
+#include <cstdint>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+namespace aot {
+
+using namespace std::literals;
+
+// Тело метода, оттранслированное в функцию C++
+class NativeMethod : public runtime::Executable {
+public:
+    using Function = runtime::ObjectHolder (*)(runtime::Closure& closure,
+        runtime::Context& context);
+
+    explicit NativeMethod(Function function)
+        : function_(function) {
+    }
+
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override {
+        return function_(closure, context);
+    }
+
+private:
+    Function function_;
+};
+
+// Место вызова метода. Оттранслированный метод вызывается через runtime::Method,
+// поэтому кэш места вызова не хранит дополнительных данных
+using CallSite = runtime::CallSite<std::monostate>;
+
+// Создаёт место вызова метода method с argument_count аргументами
+inline CallSite MakeCallSite(std::string method, std::uint32_t argument_count) {
+    CallSite site;
+    site.method = std::move(method);
+    site.argument_count = argument_count;
+    return site;
+}
+
+// Возвращает метод места вызова site для класса cls либо nullptr, если метода нет
+inline const runtime::Method* FindMethod(CallSite& site, const runtime::Class& cls) {
+    return site.Find(cls, [](const runtime::Method&) {
+        return std::monostate{};
+    }).method;
+}
+
+// Возвращает значение переменной name из closure
+inline const runtime::ObjectHolder& LoadName(const runtime::Closure& closure,
+    const std::string& name) {
+    auto it = closure.find(name);
+    if (it == closure.end()) {
+        throw std::runtime_error("Unknown variable name"s);
+    }
+    return it->second;
+}
+
+// Возвращает значение переменной из слота slot фрейма метода
+inline const runtime::ObjectHolder& LoadSlot(const runtime::FrameSlot* frame, size_t slot) {
+    if (!frame[slot]) {
+        throw std::runtime_error("Unknown variable name"s);
+    }
+    return *frame[slot];
+}
+
+// Возвращает значение поля name объекта object. Если object - не экземпляр класса,
+// возвращает сам object, как и при вычислении цепочки полей id1.id2.id3
+inline const runtime::ObjectHolder& GetField(const runtime::ObjectHolder& object,
+    const std::string& name) {
+    auto* instance = object.TryAs<runtime::ClassInstance>();
+    if (!instance) {
+        return object;
+    }
+    const runtime::ObjectHolder* field = instance->FindField(name);
+    if (!field) {
+        throw std::runtime_error("Unknown variable name"s);
+    }
+    return *field;
+}
+
+// Возвращает экземпляр класса, хранящийся в object, либо выбрасывает исключение с текстом message
+inline runtime::ClassInstance& ExpectInstance(const runtime::ObjectHolder& object,
+    const char* message) {
+    auto* instance = object.TryAs<runtime::ClassInstance>();
+    if (!instance) {
+        throw std::runtime_error(message);
+    }
+    return *instance;
+}
+
+// Вызывает метод method объекта instance, найденный функцией FindMethod
+inline runtime::ObjectHolder Call(runtime::ClassInstance& instance, const runtime::Method* method,
+    const std::vector<runtime::ObjectHolder>& args, runtime::Context& context) {
+    if (!method) {
+        throw std::runtime_error("Method not found"s);
+    }
+    return instance.Call(*method, args, context);
+}
+
+// Выводит значение object так же, как команда print
+inline void PrintValue(const runtime::ObjectHolder& object, runtime::Context& context) {
+    runtime::PrintValue(object, context.GetOutputStream(), context);
+}
+
+// Операция str
+inline runtime::ObjectHolder Stringify(const runtime::ObjectHolder& object,
+    runtime::Context& context) {
+    if (!object) {
+        return runtime::ObjectHolder::Own(runtime::String("None"s));
+    }
+    std::ostringstream out;
+    runtime::PrintValue(object, out, context);
+    return runtime::ObjectHolder::Own(runtime::String(out.str()));
+}
+
+// Приводит значение типа bool к объекту runtime::Bool
+inline runtime::ObjectHolder ToBool(bool value) {
+    return value ? runtime::ObjectHolder::True() : runtime::ObjectHolder::False();
+}
+
+}  // namespace aot
@@ -0,0 +1,248 @@
+#include "aot.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+#include "test_programs.h"
+
+#include <test_runner.h>
+
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+
+#ifdef __unix__
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+namespace aot {
+
+namespace {
+
+// Транслирует программу text в программу на C++
+string TranslateText(const string& text) {
+    istringstream is(text);
+    parse::Lexer lexer(is);
+    auto program = ParseProgram(lexer);
+    return Translate(*program);
+}
+
+bool Contains(const string& text, const string& fragment) {
+    return text.find(fragment) != string::npos;
+}
+
+#ifdef __unix__
+
+// Результат выполнения программы: вывод, сообщения об ошибках и код завершения
+struct Outcome {
+    string output;
+    string errors;
+    int exit_code = 0;
+};
+
+// Выполняет программу text обходом AST так же, как mython --engine=ast
+Outcome RunTree(const string& text) {
+    istringstream is(text);
+    parse::Lexer lexer(is);
+    auto program = ParseProgram(lexer);
+
+    Outcome outcome;
+    ostringstream output;
+    runtime::SimpleContext context{ output };
+    try {
+        runtime::Closure closure;
+        program->Execute(closure, context);
+    } catch (const std::exception& e) {
+        outcome.errors = e.what() + "\n"s;
+        outcome.exit_code = 1;
+    }
+    outcome.output = output.str();
+    return outcome;
+}
+
+// Возвращает path в виде аргумента команды оболочки
+string ShellQuote(const filesystem::path& path) {
+    string result = "'"s;
+    for (char c : path.string()) {
+        if (c == '\'') {
+            result += "'\\''"s;
+        }
+        else {
+            result += c;
+        }
+    }
+    return result + "'"s;
+}
+
+// Выполняет команду оболочки и возвращает её код завершения
+int RunCommand(const string& command) {
+    const int status = std::system(command.c_str());
+    return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+
+string ReadFile(const filesystem::path& path) {
+    ifstream in(path, ios::binary);
+    return string(istreambuf_iterator<char>(in), istreambuf_iterator<char>());
+}
+
+// Удаляет временный каталог при выходе из области видимости
+class TemporaryDirectory {
+public:
+    explicit TemporaryDirectory(filesystem::path path)
+        : path_(std::move(path)) {
+        filesystem::remove_all(path_);
+        filesystem::create_directories(path_);
+    }
+
+    TemporaryDirectory(const TemporaryDirectory&) = delete;
+    TemporaryDirectory& operator=(const TemporaryDirectory&) = delete;
+
+    ~TemporaryDirectory() {
+        error_code ignored;
+        filesystem::remove_all(path_, ignored);
+    }
+
+    [[nodiscard]] const filesystem::path& GetPath() const {
+        return path_;
+    }
+
+private:
+    filesystem::path path_;
+};
+
+#endif
+
+}  // namespace
+
+void TestQuote() {
+    ASSERT_EQUAL(Generator::Quote("hello"sv), "\"hello\""s);
+    ASSERT_EQUAL(Generator::Quote("a\"b\\c"sv), "\"a\\\"b\\\\c\""s);
+    ASSERT_EQUAL(Generator::Quote("line\n\ttab"sv), "\"line\\n\\ttab\""s);
+    ASSERT_EQUAL(Generator::Quote("\x01"sv "2"sv), "\"\\0012\""s);
+}
+
+void TestTranslateProgram() {
+    const string program = TranslateText(R"(
+class Counter:
+  def __init__(start):
+    self.value = start
+
+  def add(delta):
+    self.value = self.value + delta
+    return self.value
+
+class Named(Counter):
+  def __str__():
+    return 'counter ' + str(self.value)
+
+c = Named(1)
+c.add(2)
+print c, c.value > 2
+)"s);
+
+    ASSERT(Contains(program, "#include \"aot_support.h\""s));
+    ASSERT(Contains(program, "int main()"s));
+    // Родительский класс объявляется раньше наследника
+    const size_t counter = program.find("runtime::Class class0(\"Counter\"s, class0_methods(), nullptr)"s);
+    const size_t named = program.find("runtime::Class class1(\"Named\"s, class1_methods(), &class0)"s);
+    ASSERT(counter != string::npos);
+    ASSERT(named != string::npos);
+    ASSERT(counter < named);
+    // Методы вызываются через кэши в местах вызова, операции - через функции runtime
+    ASSERT(Contains(program, "static aot::CallSite"s));
+    ASSERT(Contains(program, "aot::MakeCallSite(\"add\"s, 1)"s));
+    ASSERT(Contains(program, "aot::FindMethod("s));
+    ASSERT(Contains(program, "runtime::Add("s));
+    ASSERT(Contains(program, "aot::ToBool(runtime::Greater("s));
+    ASSERT(Contains(program, "runtime::String(\"counter \"s)"s));
+    ASSERT(Contains(program, "aot::PrintValue("s));
+    ASSERT(Contains(program, "closure[\"c\"s] = "s));
+}
+
+void TestTranslatedPrograms() {
+#ifdef __unix__
+    // Сборка программ компилятором C++ занимает заметное время, поэтому тест выполняется,
+    // только если переменная окружения MYTHON_AOT_CXX задаёт компилятор, например g++.
+    // Иначе тест отмечается как пропущенный
+    const char* compiler = std::getenv("MYTHON_AOT_CXX");
+    if (!compiler) {
+        throw TestSkipped("set MYTHON_AOT_CXX to a C++ compiler to build translated programs"s);
+    }
+    const filesystem::path source_dir = filesystem::absolute(__FILE__).parent_path();
+    ASSERT(filesystem::exists(source_dir / "runtime.cpp"));
+    const TemporaryDirectory directory(filesystem::temp_directory_path()
+        / ("mython_aot_"s + to_string(getpid())));
+    const filesystem::path& dir = directory.GetPath();
+
+    vector<const test_programs::TestProgram*> programs;
+    for (const auto* list : { &test_programs::ParsePrograms(), &test_programs::EnginePrograms() }) {
+        for (const auto& program : *list) {
+            programs.push_back(&program);
+        }
+    }
+
+    // runtime.cpp и все программы компилируются параллельно, затем каждая программа
+    // собирается вместе с runtime.o
+    const string cxx = compiler + " -std=c++17 -I"s + ShellQuote(source_dir);
+    string compile = cxx + " -O1 -c "s + ShellQuote(source_dir / "runtime.cpp") + " -o "s
+        + ShellQuote(dir / "runtime.o") + " &\n"s;
+    for (size_t i = 0; i < programs.size(); ++i) {
+        const string name = "program"s + to_string(i);
+        ofstream(dir / (name + ".cpp"s)) << TranslateText(programs[i]->text);
+        compile += cxx + " -c "s + ShellQuote(dir / (name + ".cpp"s)) + " -o "s
+            + ShellQuote(dir / (name + ".o"s)) + " 2> "s + ShellQuote(dir / (name + ".log"s))
+            + " &\n"s;
+    }
+    compile += "wait\n"s;
+    ASSERT_EQUAL(RunCommand(compile), 0);
+
+    for (size_t i = 0; i < programs.size(); ++i) {
+        const test_programs::TestProgram& program = *programs[i];
+        const filesystem::path binary = dir / ("program"s + to_string(i));
+        const string link = cxx + " "s + ShellQuote(binary.string() + ".o"s) + " "s
+            + ShellQuote(dir / "runtime.o") + " -o "s + ShellQuote(binary) + " 2>> "s
+            + ShellQuote(binary.string() + ".log"s);
+        AssertEqual(RunCommand(link), 0,
+            program.name + " does not build: "s + ReadFile(binary.string() + ".log"s));
+
+        Outcome translated;
+        translated.exit_code = RunCommand(ShellQuote(binary) + " > "s
+            + ShellQuote(binary.string() + ".out"s) + " 2> "s
+            + ShellQuote(binary.string() + ".err"s));
+        translated.output = ReadFile(binary.string() + ".out"s);
+        translated.errors = ReadFile(binary.string() + ".err"s);
+
+        const Outcome expected = RunTree(program.text);
+        AssertEqual(translated.output, expected.output, program.name + " output"s);
+        AssertEqual(translated.errors, expected.errors, program.name + " errors"s);
+        AssertEqual(translated.exit_code, expected.exit_code, program.name + " exit code"s);
+    }
+#else
+    throw TestSkipped("translated programs are built only on Unix"s);
+#endif
+}
+
+void TestUnsupportedNode() {
+    // Произвольная функция сравнения не транслируется в C++
+    ast::Comparison comparison(
+        [](const runtime::ObjectHolder&, const runtime::ObjectHolder&, runtime::Context&) {
+            return true;
+        },
+        make_unique<ast::NumericConst>(1), make_unique<ast::NumericConst>(2));
+    try {
+        Translate(comparison);
+        ASSERT(false);
+    } catch (const runtime_error&) {
+    }
+}
+
+void RunUnitTests(TestRunner& tr) {
+    RUN_TEST(tr, aot::TestQuote);
+    RUN_TEST(tr, aot::TestTranslateProgram);
+    RUN_TEST(tr, aot::TestTranslatedPrograms);
+    RUN_TEST(tr, aot::TestUnsupportedNode);
+}
+
+}  // namespace aot
@@ -0,0 +1,121 @@
+#pragma once
+
+/*
+ * Места вызова методов и создания объектов. Встроенный кэш методов используется при обходе AST
+ * (ast::MethodCall) и движками vm и flat, места вызова и создания объектов - движками vm и flat.
+ * Места вызова методов используют и программы, полученные трансляцией в C++ (aot_support.h)
+ */
+
+#include "runtime.h"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+namespace runtime {
+
+/*
+ * Встроенный кэш места вызова метода. Запоминает методы, найденные для первых CAPACITY классов
+ * получателя, вместе с данными Data, которые место вызова вычисляет для найденного метода
+ * (например, байт-код его тела). Класс получателя служит проверкой, поэтому метод,
+ * переопределённый в классе-наследнике, находится для него заново
+ */
+template <typename Data>
+class MethodCache {
+public:
+    // Число классов, которые запоминает кэш. Когда кэш заполнен,
+    // методы остальных классов ищутся в таблице методов при каждом вызове
+    static constexpr size_t CAPACITY = 4;
+
+    struct Entry {
+        const Class* cls = nullptr;
+        const Method* method = nullptr;
+        Data data{};
+    };
+
+    // Возвращает метод name класса cls для argument_count аргументов. Если метода нет,
+    // поле method результата равно nullptr. Для метода, найденного в таблице методов класса,
+    // поле data заполняется результатом make_data(method)
+    template <typename MakeData>
+    Entry Find(const Class& cls, const std::string& name, size_t argument_count,
+        MakeData&& make_data) {
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].cls == &cls) {
+                ++hits_;
+                return entries_[i];
+            }
+        }
+        ++misses_;
+        Entry entry{ &cls, cls.GetMethod(name, argument_count) };
+        if (entry.method) {
+            entry.data = make_data(*entry.method);
+            if (size_ < CAPACITY) {
+                entries_[size_++] = entry;
+            }
+        }
+        return entry;
+    }
+
+    // Возвращает запись для класса cls, если кэш уже запомнил его, либо nullptr.
+    // В отличие от Find, не ищет метод в таблице методов класса и не изменяет кэш
+    [[nodiscard]] const Entry* Lookup(const Class& cls) const {
+        for (size_t i = 0; i < size_; ++i) {
+            if (entries_[i].cls == &cls) {
+                return &entries_[i];
+            }
+        }
+        return nullptr;
+    }
+
+    // Количество поисков, для которых метод нашёлся в кэше
+    [[nodiscard]] size_t GetHits() const {
+        return hits_;
+    }
+
+    // Количество поисков, для которых метод пришлось искать в таблице методов класса
+    [[nodiscard]] size_t GetMisses() const {
+        return misses_;
+    }
+
+private:
+    std::array<Entry, CAPACITY> entries_;
+    size_t size_ = 0;
+    size_t hits_ = 0;
+    size_t misses_ = 0;
+};
+
+// Место вызова метода method с argument_count аргументами
+template <typename Data>
+struct CallSite {
+    std::string method;
+    std::uint32_t argument_count = 0;
+    MethodCache<Data> cache;
+
+    // Возвращает метод класса cls (см. MethodCache::Find)
+    template <typename MakeData>
+    typename MethodCache<Data>::Entry Find(const Class& cls, MakeData&& make_data) {
+        return cache.Find(cls, method, argument_count, std::forward<MakeData>(make_data));
+    }
+};
+
+// Место создания объекта instance, конструктору которого передаётся argument_count аргументов
+struct NewInstanceSite {
+    ClassInstance* instance = nullptr;
+    std::uint32_t argument_count = 0;
+
+    // Возвращает метод __init__ класса объекта либо nullptr.
+    // Без подходящего метода __init__ аргументы конструктора не вычисляются
+    [[nodiscard]] const Method* FindInit() const {
+        return instance->GetClass().GetSpecialMethod(SpecialMethod::INIT, argument_count);
+    }
+};
+
+// Добавляет value в конец container и возвращает номер добавленного элемента
+template <typename Container, typename Value>
+std::uint32_t Append(Container& container, Value&& value) {
+    container.push_back(std::forward<Value>(value));
+    return static_cast<std::uint32_t>(container.size() - 1);
+}
+
+}  // namespace runtime
@@ -0,0 +1,419 @@
+#include "flat.h"
+
+#include <cassert>
+#include <stdexcept>
+
+using namespace std;
+
+namespace flat {
+
+using runtime::Append;
+using runtime::Closure;
+using runtime::Completion;
+using runtime::Context;
+using runtime::ObjectHolder;
+
+std::uint32_t Builder::AddList(const std::vector<std::unique_ptr<ast::Statement>>& nodes) {
+    // Узлы элементов добавляют свои списки, поэтому номера записываются после добавления всех узлов
+    std::vector<std::uint32_t> indices;
+    indices.reserve(nodes.size());
+    for (const auto& node : nodes) {
+        indices.push_back(Add(*node));
+    }
+    const auto begin = static_cast<std::uint32_t>(tree_.lists.size());
+    tree_.lists.insert(tree_.lists.end(), indices.begin(), indices.end());
+    return begin;
+}
+
+std::uint32_t Builder::AddNode(NodeKind kind, std::uint32_t operand, std::uint32_t first,
+    std::uint32_t second) {
+    return Append(tree_.nodes, Node{ kind, operand, first, second });
+}
+
+std::uint32_t Builder::AddConstant(ObjectHolder value) {
+    return Append(tree_.constants, std::move(value));
+}
+
+std::uint32_t Builder::AddName(const string& name) {
+    return Append(tree_.names, name);
+}
+
+std::uint32_t Builder::AddFieldPath(const ast::FieldPath& path) {
+    return Append(tree_.field_paths, path);
+}
+
+std::uint32_t Builder::AddComparison(const ast::Comparison& comparison) {
+    return Append(tree_.comparisons, &comparison);
+}
+
+std::uint32_t Builder::AddCallSite(const string& method, size_t argument_count) {
+    CallSite site;
+    site.method = method;
+    site.argument_count = static_cast<std::uint32_t>(argument_count);
+    return Append(tree_.call_sites, std::move(site));
+}
+
+std::uint32_t Builder::AddNewInstance(runtime::ClassInstance& instance, size_t argument_count) {
+    return Append(tree_.new_instances,
+        NewInstanceSite{ &instance, static_cast<std::uint32_t>(argument_count) });
+}
+
+std::uint32_t Builder::AddStatement(ast::Statement& node) {
+    return Append(tree_.statements, &node);
+}
+
+Program::Program(ast::Statement& program) {
+    Builder builder(main_);
+    main_.root = builder.Add(program);
+}
+
+void Program::Execute(Closure& closure, Context& context) {
+    Activation activation{ main_, closure, context.GetFrame(), context };
+    ObjectHolder return_value;
+    Run(activation, main_.root, return_value);
+}
+
+Tree* Program::GetMethodTree(const runtime::Method& method) {
+    auto [it, inserted] = methods_.emplace(&method, nullptr);
+    if (inserted) {
+        if (auto* body = ast::MethodBody::GetTranslatable(method)) {
+            auto tree = make_unique<Tree>();
+            Builder builder(*tree);
+            tree->root = builder.Add(*body);
+            it->second = std::move(tree);
+        }
+    }
+    return it->second.get();
+}
+
+ObjectHolder Program::Invoke(runtime::ClassInstance& instance, const runtime::Method& method,
+    Tree* tree, runtime::FrameSlot* frame, Context& context) {
+    if (!tree) {
+        return instance.CallInFrame(method, frame, context);
+    }
+    frame[0] = ObjectHolder::Share(instance);
+    runtime::FrameScope frame_scope(context, frame);
+    Closure closure;
+    Activation activation{ *tree, closure, frame, context };
+    ObjectHolder return_value;
+    Run(activation, tree->root, return_value);
+    return return_value;
+}
+
+void Program::EvaluateArguments(Activation& activation, std::uint32_t list, std::uint32_t count,
+    runtime::FrameSlot* frame) {
+    const std::uint32_t* arguments = activation.tree.lists.data() + list;
+    for (std::uint32_t i = 0; i < count; ++i) {
+        frame[i + 1] = Evaluate(activation, arguments[i]);
+    }
+}
+
+Completion Program::Run(Activation& activation, std::uint32_t index, ObjectHolder& return_value) {
+    const Node& node = activation.tree.nodes[index];
+    switch (node.kind) {
+    case NodeKind::SEQUENCE: {
+        const std::uint32_t* statements = activation.tree.lists.data() + node.first;
+        for (std::uint32_t i = 0; i < node.operand; ++i) {
+            if (Run(activation, statements[i], return_value) == Completion::RETURN) {
+                return Completion::RETURN;
+            }
+        }
+        return Completion::NORMAL;
+    }
+    case NodeKind::IF_ELSE:
+        if (runtime::IsTrue(Evaluate(activation, node.first))) {
+            return Run(activation, node.second, return_value);
+        }
+        if (node.operand != NO_NODE) {
+            return Run(activation, node.operand, return_value);
+        }
+        return Completion::NORMAL;
+    case NodeKind::RETURN:
+        return_value = Evaluate(activation, node.first);
+        return Completion::RETURN;
+    case NodeKind::EXECUTE:
+        return activation.tree.statements[node.operand]->ExecuteStatement(activation.closure,
+            activation.context, return_value);
+    default:
+        Evaluate(activation, index);
+        return Completion::NORMAL;
+    }
+}
+
+ObjectHolder Program::Evaluate(Activation& activation, std::uint32_t index) {
+    Tree& tree = activation.tree;
+    Context& context = activation.context;
+    const Node& node = tree.nodes[index];
+    switch (node.kind) {
+    case NodeKind::CONSTANT:
+        return tree.constants[node.operand];
+    case NodeKind::NONE:
+        return ObjectHolder::None();
+    case NodeKind::LOAD_LOCAL: {
+        const runtime::FrameSlot& variable = activation.frame[node.operand];
+        if (!variable) {
+            throw runtime_error("Unknown variable name"s);
+        }
+        return *variable;
+    }
+    case NodeKind::LOAD_NAME: {
+        auto it = activation.closure.find(tree.names[node.operand]);
+        if (it == activation.closure.end()) {
+            throw runtime_error("Unknown variable name"s);
+        }
+        return it->second;
+    }
+    case NodeKind::LOAD_FIELDS: {
+        const ObjectHolder object = Evaluate(activation, node.first);
+        return tree.field_paths[node.operand].Resolve(object);
+    }
+    case NodeKind::STORE_LOCAL:
+        return *(activation.frame[node.operand] = Evaluate(activation, node.first));
+    case NodeKind::STORE_NAME:
+        return activation.closure[tree.names[node.operand]] = Evaluate(activation, node.first);
+    case NodeKind::STORE_FIELD: {
+        const ObjectHolder object = Evaluate(activation, node.first);
+        auto* instance = object.TryAs<runtime::ClassInstance>();
+        if (!instance) {
+            throw runtime_error("Object must be a ClassInstance to assign a field"s);
+        }
+        return instance->SetField(tree.names[node.operand], Evaluate(activation, node.second));
+    }
+    case NodeKind::ADD: {
+        const ObjectHolder lhs = Evaluate(activation, node.first);
+        return runtime::Add(lhs, Evaluate(activation, node.second), context);
+    }
+    case NodeKind::SUB: {
+        const ObjectHolder lhs = Evaluate(activation, node.first);
+        return runtime::Sub(lhs, Evaluate(activation, node.second), context);
+    }
+    case NodeKind::MULT: {
+        const ObjectHolder lhs = Evaluate(activation, node.first);
+        return runtime::Mult(lhs, Evaluate(activation, node.second), context);
+    }
+    case NodeKind::DIV: {
+        const ObjectHolder lhs = Evaluate(activation, node.first);
+        return runtime::Div(lhs, Evaluate(activation, node.second), context);
+    }
+    case NodeKind::COMPARE: {
+        const ObjectHolder lhs = Evaluate(activation, node.first);
+        return tree.comparisons[node.operand]->Apply(lhs, Evaluate(activation, node.second),
+            context);
+    }
+    case NodeKind::AND:
+        if (!runtime::IsTrue(Evaluate(activation, node.first))) {
+            return ObjectHolder::False();
+        }
+        return runtime::IsTrue(Evaluate(activation, node.second)) ? ObjectHolder::True()
+                                                                  : ObjectHolder::False();
+    case NodeKind::OR:
+        if (runtime::IsTrue(Evaluate(activation, node.first))) {
+            return ObjectHolder::True();
+        }
+        return runtime::IsTrue(Evaluate(activation, node.second)) ? ObjectHolder::True()
+                                                                  : ObjectHolder::False();
+    case NodeKind::NOT:
+        return ast::Not::Apply(Evaluate(activation, node.first));
+    case NodeKind::STRINGIFY:
+        return ast::Stringify::Apply(Evaluate(activation, node.first), context);
+    case NodeKind::PRINT: {
+        std::ostream& out = context.GetOutputStream();
+        for (std::uint32_t i = 0; i < node.operand; ++i) {
+            if (i > 0) {
+                out << ' ';
+            }
+            const ObjectHolder value = Evaluate(activation, tree.lists[node.first + i]);
+            ast::Print::PrintValue(value, out, context);
+        }
+        out << '\n';
+        return ObjectHolder::None();
+    }
+    case NodeKind::CALL_METHOD: {
+        const ObjectHolder object = Evaluate(activation, node.first);
+        auto* instance = object.TryAs<runtime::ClassInstance>();
+        if (!instance) {
+            throw runtime_error("Object must be a ClassInstance to call a method"s);
+        }
+        CallSite& site = tree.call_sites[node.operand];
+        const auto entry = site.Find(instance->GetClass(), [this](const runtime::Method& method) {
+            return GetMethodTree(method);
+        });
+        if (!entry.method) {
+            // Аргументы вычисляются и при отсутствии метода, как при обходе AST
+            runtime::StackFrame frame(context.GetFrameStack(), site.argument_count + 1);
+            EvaluateArguments(activation, node.second, site.argument_count, frame.Get());
+            throw runtime_error("Method not found"s);
+        }
+
+        runtime::StackFrame frame(context.GetFrameStack(),
+            runtime::ClassInstance::GetFrameSize(*entry.method));
+        EvaluateArguments(activation, node.second, site.argument_count, frame.Get());
+        return Invoke(*instance, *entry.method, entry.data, frame.Get(), context);
+    }
+    case NodeKind::NEW_INSTANCE: {
+        const NewInstanceSite& site = tree.new_instances[node.operand];
+        if (const runtime::Method* init = site.FindInit()) {
+            runtime::StackFrame frame(context.GetFrameStack(),
+                runtime::ClassInstance::GetFrameSize(*init));
+            EvaluateArguments(activation, node.first, site.argument_count, frame.Get());
+            Invoke(*site.instance, *init, GetMethodTree(*init), frame.Get(), context);
+        }
+        return ObjectHolder::Share(*site.instance);
+    }
+    case NodeKind::EXECUTE:
+        return tree.statements[node.operand]->Execute(activation.closure, context);
+    case NodeKind::SEQUENCE:
+    case NodeKind::IF_ELSE:
+    case NodeKind::RETURN: {
+        // Инструкции не имеют значения
+        ObjectHolder return_value;
+        Run(activation, index, return_value);
+        return ObjectHolder::None();
+    }
+    }
+    assert(false);
+    return ObjectHolder::None();
+}
+
+}  // namespace flat
+
+// Перевод узлов AST в дерево с замкнутым набором видов узлов
+
+namespace ast {
+
+using flat::NodeKind;
+
+std::uint32_t Statement::Flatten(flat::Builder& builder) {
+    return builder.AddNode(NodeKind::EXECUTE, builder.AddStatement(*this));
+}
+
+std::uint32_t FlattenConstant(flat::Builder& builder, runtime::ObjectHolder value) {
+    return builder.AddNode(NodeKind::CONSTANT, builder.AddConstant(std::move(value)));
+}
+
+std::uint32_t None::Flatten(flat::Builder& builder) {
+    return builder.AddNode(NodeKind::NONE);
+}
+
+std::uint32_t VariableValue::Flatten(flat::Builder& builder) {
+    const std::uint32_t variable = slot_ != MethodScope::NO_SLOT
+        ? builder.AddNode(NodeKind::LOAD_LOCAL, static_cast<std::uint32_t>(slot_))
+        : builder.AddNode(NodeKind::LOAD_NAME, builder.AddName(var_name_));
+    if (field_path_.IsEmpty()) {
+        return variable;
+    }
+    return builder.AddNode(NodeKind::LOAD_FIELDS, builder.AddFieldPath(field_path_), variable);
+}
+
+std::uint32_t Assignment::Flatten(flat::Builder& builder) {
+    const std::uint32_t value = builder.Add(*rv_);
+    if (slot_ != MethodScope::NO_SLOT) {
+        return builder.AddNode(NodeKind::STORE_LOCAL, static_cast<std::uint32_t>(slot_), value);
+    }
+    return builder.AddNode(NodeKind::STORE_NAME, builder.AddName(var_), value);
+}
+
+std::uint32_t FieldAssignment::Flatten(flat::Builder& builder) {
+    const std::uint32_t object = builder.Add(object_);
+    const std::uint32_t value = builder.Add(*rv_);
+    return builder.AddNode(NodeKind::STORE_FIELD, builder.AddName(field_name_), object, value);
+}
+
+std::uint32_t Print::Flatten(flat::Builder& builder) {
+    const std::uint32_t args = builder.AddList(args_);
+    return builder.AddNode(NodeKind::PRINT, static_cast<std::uint32_t>(args_.size()), args);
+}
+
+std::uint32_t MethodCall::Flatten(flat::Builder& builder) {
+    const std::uint32_t object = builder.Add(*object_);
+    const std::uint32_t args = builder.AddList(args_);
+    return builder.AddNode(NodeKind::CALL_METHOD, builder.AddCallSite(method_, args_.size()),
+        object, args);
+}
+
+std::uint32_t NewInstance::Flatten(flat::Builder& builder) {
+    const std::uint32_t args = builder.AddList(args_);
+    return builder.AddNode(NodeKind::NEW_INSTANCE,
+        builder.AddNewInstance(class_p_, args_.size()), args);
+}
+
+std::uint32_t Stringify::Flatten(flat::Builder& builder) {
+    return builder.AddNode(NodeKind::STRINGIFY, 0, builder.Add(*argument_));
+}
+
+std::uint32_t Not::Flatten(flat::Builder& builder) {
+    return builder.AddNode(NodeKind::NOT, 0, builder.Add(*argument_));
+}
+
+std::uint32_t Add::Flatten(flat::Builder& builder) {
+    const std::uint32_t lhs = builder.Add(*lhs_);
+    return builder.AddNode(NodeKind::ADD, 0, lhs, builder.Add(*rhs_));
+}
+
+std::uint32_t Sub::Flatten(flat::Builder& builder) {
+    const std::uint32_t lhs = builder.Add(*lhs_);
+    return builder.AddNode(NodeKind::SUB, 0, lhs, builder.Add(*rhs_));
+}
+
+std::uint32_t Mult::Flatten(flat::Builder& builder) {
+    const std::uint32_t lhs = builder.Add(*lhs_);
+    return builder.AddNode(NodeKind::MULT, 0, lhs, builder.Add(*rhs_));
+}
+
+std::uint32_t Div::Flatten(flat::Builder& builder) {
+    const std::uint32_t lhs = builder.Add(*lhs_);
+    return builder.AddNode(NodeKind::DIV, 0, lhs, builder.Add(*rhs_));
+}
+
+std::uint32_t Comparison::Flatten(flat::Builder& builder) {
+    const std::uint32_t lhs = builder.Add(*lhs_);
+    const std::uint32_t rhs = builder.Add(*rhs_);
+    return builder.AddNode(NodeKind::COMPARE, builder.AddComparison(*this), lhs, rhs);
+}
+
+std::uint32_t Or::Flatten(flat::Builder& builder) {
+    const std::uint32_t lhs = builder.Add(*lhs_);
+    return builder.AddNode(NodeKind::OR, 0, lhs, builder.Add(*rhs_));
+}
+
+std::uint32_t And::Flatten(flat::Builder& builder) {
+    const std::uint32_t lhs = builder.Add(*lhs_);
+    return builder.AddNode(NodeKind::AND, 0, lhs, builder.Add(*rhs_));
+}
+
+std::uint32_t Compound::Flatten(flat::Builder& builder) {
+    const std::uint32_t statements = builder.AddList(args_);
+    return builder.AddNode(NodeKind::SEQUENCE, static_cast<std::uint32_t>(args_.size()),
+        statements);
+}
+
+std::uint32_t MethodBody::Flatten(flat::Builder& builder) {
+    return builder.Add(*body_);
+}
+
+std::uint32_t Return::Flatten(flat::Builder& builder) {
+    return builder.AddNode(NodeKind::RETURN, 0, builder.Add(*statement_));
+}
+
+std::uint32_t IfElse::Flatten(flat::Builder& builder) {
+    const std::uint32_t condition = builder.Add(*condition_);
+    const std::uint32_t if_body = builder.Add(*if_body_);
+    const std::uint32_t else_body = else_body_ ? builder.Add(*else_body_) : flat::NO_NODE;
+    return builder.AddNode(NodeKind::IF_ELSE, else_body, condition, if_body);
+}
+
+std::uint32_t FieldIncrement::Flatten(flat::Builder& builder) {
+    // object.field_name = object.field_name + increment: объект - переменная либо цепочка
+    // полей, поэтому его повторное вычисление не меняет результат
+    const std::uint32_t object = builder.Add(object_);
+    const std::uint32_t field = builder.AddNode(NodeKind::LOAD_FIELDS,
+        builder.AddFieldPath(FieldPath({ field_name_ })), builder.Add(object_));
+    const std::uint32_t sum = builder.AddNode(NodeKind::ADD, 0, field, builder.Add(*increment_));
+    return builder.AddNode(NodeKind::STORE_FIELD, builder.AddName(field_name_), object, sum);
+}
+
+std::uint32_t ReturnVariable::Flatten(flat::Builder& builder) {
+    return builder.AddNode(NodeKind::RETURN, 0, builder.Add(variable_));
+}
+
+}  // namespace ast
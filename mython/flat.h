@@ -0,0 +1,155 @@
+#pragma once
+
+#include "call_site.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace flat {
+
+// Номер узла, которого нет (например, ветки else в инструкции if без else)
+constexpr std::uint32_t NO_NODE = static_cast<std::uint32_t>(-1);
+
+// Вид узла. Набор видов замкнут: узел выполняется веткой switch, а не виртуальным вызовом
+enum class NodeKind : std::uint8_t {
+    CONSTANT,      // константа с номером operand
+    NONE,          // значение None
+    LOAD_LOCAL,    // значение слота operand фрейма метода
+    LOAD_NAME,     // значение переменной с именем operand из closure
+    LOAD_FIELDS,   // значение цепочки полей operand объекта first
+    STORE_LOCAL,   // присваивает слоту operand значение first
+    STORE_NAME,    // присваивает переменной с именем operand значение first
+    STORE_FIELD,   // присваивает полю с именем operand объекта first значение second
+    ADD,           // first + second
+    SUB,           // first - second
+    MULT,          // first * second
+    DIV,           // first / second
+    COMPARE,       // результат сравнения operand значений first и second
+    AND,           // first and second
+    OR,            // first or second
+    NOT,           // not first
+    STRINGIFY,     // str(first)
+    PRINT,         // выводит значения operand узлов из списка first
+    CALL_METHOD,   // вызов метода (место вызова operand) объекта first с аргументами из списка second
+    NEW_INSTANCE,  // создание объекта (место создания operand) с аргументами из списка first
+    SEQUENCE,      // выполняет operand инструкций из списка first
+    IF_ELSE,       // if first: second else: operand (NO_NODE, если ветки else нет)
+    RETURN,        // return first
+    EXECUTE,       // результат Execute узла AST с номером operand
+};
+
+// Узел дерева. Дочерние узлы и данные задаются номерами в массивах Tree
+struct Node {
+    NodeKind kind;
+    std::uint32_t operand = 0;
+    std::uint32_t first = NO_NODE;
+    std::uint32_t second = NO_NODE;
+};
+
+struct Tree;
+
+// Место вызова метода. Кэш запоминает вместе с методом дерево его тела
+// (nullptr, если тело метода выполняется обходом AST)
+using CallSite = runtime::CallSite<Tree*>;
+using runtime::NewInstanceSite;
+
+/*
+ * Дерево программы либо тела метода. Узлы хранятся в одном массиве и ссылаются на дочерние
+ * узлы по номерам, поэтому дерево занимает непрерывную память без указателей на узлы.
+ * Дочерние узлы добавляются раньше родителя, корень дерева - последний узел
+ */
+struct Tree {
+    std::vector<Node> nodes;
+    // Списки дочерних узлов (аргументы, инструкции блока): номера узлов, идущие подряд
+    std::vector<std::uint32_t> lists;
+    std::vector<runtime::ObjectHolder> constants;
+    std::vector<std::string> names;
+    std::vector<ast::FieldPath> field_paths;
+    std::vector<const ast::Comparison*> comparisons;
+    std::vector<CallSite> call_sites;
+    std::vector<NewInstanceSite> new_instances;
+    std::vector<ast::Statement*> statements;
+    std::uint32_t root = NO_NODE;
+};
+
+// Переводит узлы AST в дерево tree. Узлы AST должны существовать, пока используется tree
+class Builder {
+public:
+    explicit Builder(Tree& tree)
+        : tree_(tree) {
+    }
+
+    // Добавляет узлы, соответствующие node, и возвращает номер корневого из них
+    std::uint32_t Add(ast::Statement& node) {
+        return node.Flatten(*this);
+    }
+
+    // Добавляет узлы для каждого элемента nodes и возвращает номер начала их списка
+    std::uint32_t AddList(const std::vector<std::unique_ptr<ast::Statement>>& nodes);
+
+    // Добавляет узел и возвращает его номер
+    std::uint32_t AddNode(NodeKind kind, std::uint32_t operand = 0,
+        std::uint32_t first = NO_NODE, std::uint32_t second = NO_NODE);
+
+    std::uint32_t AddConstant(runtime::ObjectHolder value);
+    std::uint32_t AddName(const std::string& name);
+    std::uint32_t AddFieldPath(const ast::FieldPath& path);
+    std::uint32_t AddComparison(const ast::Comparison& comparison);
+    std::uint32_t AddCallSite(const std::string& method, size_t argument_count);
+    std::uint32_t AddNewInstance(runtime::ClassInstance& instance, size_t argument_count);
+    std::uint32_t AddStatement(ast::Statement& node);
+
+private:
+    Tree& tree_;
+};
+
+/*
+ * Программа на Mython, переведённая в дерево с замкнутым набором видов узлов.
+ * Тело метода переводится в дерево при первом вызове из дерева программы, остальные вызовы
+ * и требования к времени жизни AST - те же, что у vm::Program
+ */
+class Program {
+public:
+    explicit Program(ast::Statement& program);
+
+    // Выполняет программу, используя closure для хранения переменных верхнего уровня
+    void Execute(runtime::Closure& closure, runtime::Context& context);
+
+private:
+    // Дерево, которое выполняется, и его окружение
+    struct Activation {
+        Tree& tree;
+        runtime::Closure& closure;
+        runtime::FrameSlot* frame;
+        runtime::Context& context;
+    };
+
+    // Вычисляет значение узла index
+    runtime::ObjectHolder Evaluate(Activation& activation, std::uint32_t index);
+
+    // Выполняет инструкцию index. Если выполнена инструкция return, записывает
+    // её результат в return_value
+    runtime::Completion Run(Activation& activation, std::uint32_t index,
+        runtime::ObjectHolder& return_value);
+
+    // Вычисляет аргументы из списка list и записывает их в слоты frame[1..count]
+    void EvaluateArguments(Activation& activation, std::uint32_t list, std::uint32_t count,
+        runtime::FrameSlot* frame);
+
+    // Вызывает метод method объекта instance с аргументами из слотов frame
+    runtime::ObjectHolder Invoke(runtime::ClassInstance& instance, const runtime::Method& method,
+        Tree* tree, runtime::FrameSlot* frame, runtime::Context& context);
+
+    // Возвращает дерево тела метода либо nullptr, если тело метода выполняется обходом AST
+    Tree* GetMethodTree(const runtime::Method& method);
+
+    Tree main_;
+    std::unordered_map<const runtime::Method*, std::unique_ptr<Tree>> methods_;
+};
+
+}  // namespace flat
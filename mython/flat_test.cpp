@@ -0,0 +1,52 @@
+#include "flat.h"
+#include "lexer.h"
+#include "parse.h"
+#include "test_programs.h"
+
+#include <test_runner.h>
+
+using namespace std;
+
+namespace flat {
+
+namespace {
+
+unique_ptr<ast::Statement> Parse(const string& program) {
+    istringstream is(program);
+    parse::Lexer lexer(is);
+    return ParseProgram(lexer);
+}
+
+// Выполняет программу по дереву с замкнутым набором узлов
+void ExecuteFlattened(ast::Statement& program, runtime::Closure& closure,
+    runtime::Context& context) {
+    Program(program).Execute(closure, context);
+}
+
+}  // namespace
+
+void TestTreeLayout() {
+    auto program = Parse("x = 1 + 2\nprint x, 'a'\n"s);
+    Tree tree;
+    Builder builder(tree);
+    tree.root = builder.Add(*program);
+
+    // Дочерние узлы добавляются раньше родителя
+    ASSERT_EQUAL(tree.root, static_cast<std::uint32_t>(tree.nodes.size() - 1));
+    ASSERT(tree.nodes[tree.root].kind == NodeKind::SEQUENCE);
+    ASSERT_EQUAL(tree.nodes[tree.root].operand, 2u);
+    const Node& print = tree.nodes[tree.lists[tree.nodes[tree.root].first + 1]];
+    ASSERT(print.kind == NodeKind::PRINT);
+    ASSERT_EQUAL(print.operand, 2u);
+    ASSERT(tree.nodes[tree.lists[print.first]].kind == NodeKind::LOAD_NAME);
+    ASSERT(tree.nodes[tree.lists[print.first + 1]].kind == NodeKind::CONSTANT);
+    ASSERT(tree.statements.empty());
+    ASSERT_EQUAL(sizeof(Node), 4 * sizeof(std::uint32_t));
+}
+
+void RunUnitTests(TestRunner& tr) {
+    RUN_TEST(tr, flat::TestTreeLayout);
+    test_programs::RunEngineTests(tr, "flat"s, ExecuteFlattened);
+}
+
+}  // namespace flat
@@ -0,0 +1,622 @@
+#include "jit.h"
+
+#include "statement.h"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+
+#if defined(__x86_64__) && defined(__linux__)
+#include <sys/mman.h>
+#define MYTHON_JIT_SUPPORTED 1
+#else
+#define MYTHON_JIT_SUPPORTED 0
+#endif
+
+using namespace std;
+
+namespace jit {
+
+namespace {
+
+// Результат выполнения машинного кода, возвращаемый в eax
+enum Status : std::int32_t {
+    RETURN_NUMBER,
+    RETURN_BOOL,
+    RETURN_NONE,
+    DEOPTIMIZE,
+};
+
+// Размер смещения в командах перехода
+constexpr size_t REL32_SIZE = 4;
+
+// Вторые байты команд условного перехода jcc rel32
+constexpr std::uint8_t JZ = 0x84;
+constexpr std::uint8_t JNZ = 0x85;
+
+// Значение слота фрейма, в который ещё не записано значение переменной.
+// Значения переменных хранятся в слотах расширенными до int64_t и не совпадают с ним
+constexpr std::int64_t UNDEFINED_SLOT = std::numeric_limits<std::int64_t>::min();
+
+// Результат функции-помощника, которая не нашла значения: метод нужно выполнить обходом AST
+constexpr std::int64_t NO_VALUE = 0;
+
+// Упаковывает число value в результат функции-помощника: младшие 32 бита содержат число,
+// старшие - признак наличия значения
+std::int64_t PackNumber(std::int32_t value) {
+    return (std::int64_t{ 1 } << 32) | static_cast<std::uint32_t>(value);
+}
+
+std::int64_t PackNumber(const runtime::ObjectHolder* value) {
+    if (!value || value->GetKind() != runtime::ObjectKind::NUMBER) {
+        return NO_VALUE;
+    }
+    return PackNumber(value->GetNumber());
+}
+
+/*
+Функции-помощники, которые вызывает машинный код. Они не выбрасывают исключений, так как
+исключение не может пройти через кадры стека машинного кода
+*/
+
+// Возвращает упакованное число - значение цепочки полей path объекта self
+std::int64_t LoadNumberField(const ast::FieldPath* path, runtime::ClassInstance* self) noexcept {
+    return PackNumber(path->ResolveCached(*self));
+}
+
+// Возвращает адрес экземпляра класса - значения цепочки полей path объекта self либо nullptr
+runtime::ClassInstance* LoadInstanceField(const ast::FieldPath* path,
+    runtime::ClassInstance* self) noexcept {
+    const runtime::ObjectHolder* value = path->ResolveCached(*self);
+    return value ? value->TryAs<runtime::ClassInstance>() : nullptr;
+}
+
+// Вызывает метод узлом call. values - вершина машинного стека, на который помещены
+// адрес объекта-получателя и затем argument_count аргументов
+std::int64_t CallMethod(ast::MethodCall* call, const std::int64_t* values,
+    std::uint32_t argument_count) noexcept {
+    std::array<std::int32_t, MAX_PARAMS> args{};
+    for (size_t i = 0; i < argument_count; ++i) {
+        args[i] = static_cast<std::int32_t>(values[argument_count - 1 - i]);
+    }
+    auto* receiver = reinterpret_cast<runtime::ClassInstance*>(values[argument_count]);
+    const std::optional<std::int32_t> result = call->CallNative(*receiver, args.data());
+    return result ? PackNumber(*result) : NO_VALUE;
+}
+
+}  // namespace
+
+bool IsSupported() {
+    return MYTHON_JIT_SUPPORTED != 0;
+}
+
+/*
+Соглашение о вызовах System V: rdi - адрес фрейма, rsi - адрес результата. Пролог сохраняет
+их в r12 и r13, которые функции-помощники не изменяют. Промежуточные значения выражений
+сохраняются на машинном стеке, поэтому пролог запоминает rsp в rbx, а все выходы из кода
+восстанавливают его. r15 хранит rsp на время вызова функции-помощника
+*/
+Emitter::Emitter(size_t param_count)
+    : param_count_(param_count)
+    , slot_types_(param_count + 1, ValueType::NUMBER) {
+    // Слот 0 занимает self, он не хранит числа
+    slot_types_[0] = ValueType::UNSUPPORTED;
+    Emit({ 0x53 });              // push rbx
+    Emit({ 0x41, 0x54 });        // push r12
+    Emit({ 0x41, 0x55 });        // push r13
+    Emit({ 0x41, 0x57 });        // push r15
+    Emit({ 0x49, 0x89, 0xFC });  // mov r12, rdi
+    Emit({ 0x49, 0x89, 0xF5 });  // mov r13, rsi
+    Emit({ 0x48, 0x89, 0xE3 });  // mov rbx, rsp
+}
+
+void Emitter::LoadConstant(std::int32_t value) {
+    Emit({ 0xB8 });  // mov eax, imm32
+    EmitInt32(value);
+}
+
+ValueType Emitter::LoadSlot(size_t slot) {
+    if (slot >= slot_types_.size() || slot_types_[slot] == ValueType::UNSUPPORTED) {
+        return ValueType::UNSUPPORTED;
+    }
+    const auto offset = static_cast<std::int32_t>(slot * sizeof(std::int64_t));
+    // Слоты 1..param_count - параметры метода, они заполнены всегда
+    if (slot <= param_count_) {
+        Emit({ 0x41, 0x8B, 0x84, 0x24 });  // mov eax, [r12 + disp32]
+        EmitInt32(offset);
+        return slot_types_[slot];
+    }
+    // Локальной переменной могли не присвоить значение, например, в невыполненной ветке if
+    Emit({ 0x49, 0x8B, 0x84, 0x24 });  // mov rax, [r12 + disp32]
+    EmitInt32(offset);
+    Emit({ 0x48, 0x63, 0xC8 });        // movsxd rcx, eax
+    Emit({ 0x48, 0x39, 0xC8 });        // cmp rax, rcx
+    DeoptimizeIf(JNZ);
+    return slot_types_[slot];
+}
+
+bool Emitter::StoreSlot(size_t slot, ValueType type) {
+    if (slot == 0 || slot >= MAX_SLOTS) {
+        return false;
+    }
+    if (slot >= slot_types_.size()) {
+        slot_types_.resize(slot + 1, ValueType::UNSUPPORTED);
+    }
+    if (slot_types_[slot] != ValueType::UNSUPPORTED && slot_types_[slot] != type) {
+        return false;
+    }
+    slot_types_[slot] = type;
+    Emit({ 0x48, 0x98 });              // cdqe
+    Emit({ 0x49, 0x89, 0x84, 0x24 });  // mov [r12 + disp32], rax
+    EmitInt32(static_cast<std::int32_t>(slot * sizeof(std::int64_t)));
+    return true;
+}
+
+void Emitter::LoadField(ast::FieldPath& path) {
+    Emit({ 0x48, 0xBF });              // mov rdi, imm64
+    EmitInt64(reinterpret_cast<std::intptr_t>(&path));
+    Emit({ 0x49, 0x8B, 0x34, 0x24 });  // mov rsi, [r12]
+    EmitCall(reinterpret_cast<const void*>(&LoadNumberField));
+    DeoptimizeIfNoValue();
+}
+
+void Emitter::LoadInstance(ast::FieldPath& path) {
+    if (path.IsEmpty()) {
+        Emit({ 0x49, 0x8B, 0x04, 0x24 });  // mov rax, [r12]
+        return;
+    }
+    Emit({ 0x48, 0xBF });              // mov rdi, imm64
+    EmitInt64(reinterpret_cast<std::intptr_t>(&path));
+    Emit({ 0x49, 0x8B, 0x34, 0x24 });  // mov rsi, [r12]
+    EmitCall(reinterpret_cast<const void*>(&LoadInstanceField));
+    Emit({ 0x48, 0x85, 0xC0 });        // test rax, rax
+    DeoptimizeIf(JZ);
+}
+
+ValueType Emitter::EmitMethodCall(ast::MethodCall& call,
+    const std::vector<std::unique_ptr<ast::Statement>>& args) {
+    if (args.size() > MAX_PARAMS) {
+        return ValueType::UNSUPPORTED;
+    }
+    Emit({ 0x50 });  // push rax
+    for (const auto& arg : args) {
+        if (arg->EmitNative(*this) != ValueType::NUMBER) {
+            return ValueType::UNSUPPORTED;
+        }
+        Emit({ 0x50 });  // push rax
+    }
+    Emit({ 0x48, 0xBF });        // mov rdi, imm64
+    EmitInt64(reinterpret_cast<std::intptr_t>(&call));
+    Emit({ 0x48, 0x89, 0xE6 });  // mov rsi, rsp
+    Emit({ 0xBA });              // mov edx, imm32
+    EmitInt32(static_cast<std::int32_t>(args.size()));
+    EmitCall(reinterpret_cast<const void*>(&CallMethod));
+    Emit({ 0x48, 0x81, 0xC4 });  // add rsp, imm32
+    EmitInt32(static_cast<std::int32_t>((args.size() + 1) * sizeof(std::int64_t)));
+    DeoptimizeIfNoValue();
+    return ValueType::NUMBER;
+}
+
+bool Emitter::EmitOperands(ast::Statement& lhs, ast::Statement& rhs) {
+    if (lhs.EmitNative(*this) != ValueType::NUMBER) {
+        return false;
+    }
+    Emit({ 0x50 });  // push rax
+    if (rhs.EmitNative(*this) != ValueType::NUMBER) {
+        return false;
+    }
+    Emit({ 0x89, 0xC1 });  // mov ecx, eax
+    Emit({ 0x58 });        // pop rax
+    return true;
+}
+
+ValueType Emitter::EmitArithmetic(ast::Statement& lhs, ast::Statement& rhs, ArithmeticOp op) {
+    if (!EmitOperands(lhs, rhs)) {
+        return ValueType::UNSUPPORTED;
+    }
+    switch (op) {
+    case ArithmeticOp::ADD:
+        Emit({ 0x01, 0xC8 });  // add eax, ecx
+        break;
+    case ArithmeticOp::SUB:
+        Emit({ 0x29, 0xC8 });  // sub eax, ecx
+        break;
+    case ArithmeticOp::MULT:
+        Emit({ 0x0F, 0xAF, 0xC1 });  // imul eax, ecx
+        break;
+    case ArithmeticOp::DIV:
+        // Деление на 0 выполняется обходом AST, который и сообщает об ошибке
+        Emit({ 0x85, 0xC9 });        // test ecx, ecx
+        DeoptimizeIf(JZ);
+        // Деление на -1 заменяется сменой знака, так как idiv INT_MIN, -1 вызывает исключение
+        Emit({ 0x83, 0xF9, 0xFF });  // cmp ecx, -1
+        Emit({ 0x75, 0x04 });        // jne divide
+        Emit({ 0xF7, 0xD8 });        // neg eax
+        Emit({ 0xEB, 0x03 });        // jmp end
+        Emit({ 0x99 });              // divide: cdq
+        Emit({ 0xF7, 0xF9 });        // idiv ecx
+        break;                       // end:
+    }
+    return ValueType::NUMBER;
+}
+
+ValueType Emitter::EmitComparison(ast::Statement& lhs, ast::Statement& rhs, CompareOp op) {
+    if (!EmitOperands(lhs, rhs)) {
+        return ValueType::UNSUPPORTED;
+    }
+    // Коды команд setcc для операций сравнения чисел со знаком
+    static constexpr std::array<std::uint8_t, 6> SETCC = {
+        0x9C,  // setl
+        0x9F,  // setg
+        0x94,  // sete
+        0x95,  // setne
+        0x9E,  // setle
+        0x9D,  // setge
+    };
+    Emit({ 0x39, 0xC8 });                                  // cmp eax, ecx
+    Emit({ 0x0F, SETCC[static_cast<size_t>(op)], 0xC0 });  // setcc al
+    Emit({ 0x0F, 0xB6, 0xC0 });                            // movzx eax, al
+    return ValueType::BOOL;
+}
+
+size_t Emitter::JumpIfFalse() {
+    Emit({ 0x85, 0xC0 });  // test eax, eax
+    Emit({ 0x0F, 0x84 });  // jz rel32
+    const size_t jump = code_.size();
+    EmitInt32(0);
+    return jump;
+}
+
+size_t Emitter::Jump() {
+    Emit({ 0xE9 });  // jmp rel32
+    const size_t jump = code_.size();
+    EmitInt32(0);
+    return jump;
+}
+
+void Emitter::Bind(size_t jump) {
+    const auto offset = static_cast<std::int32_t>(code_.size() - (jump + REL32_SIZE));
+    std::memcpy(code_.data() + jump, &offset, sizeof(offset));
+}
+
+void Emitter::Return(ValueType type) {
+    Emit({ 0x41, 0x89, 0x45, 0x00 });  // mov [r13], eax
+    EmitExit(type == ValueType::BOOL ? RETURN_BOOL : RETURN_NUMBER);
+}
+
+std::vector<std::uint8_t> Emitter::Finish() {
+    // Выполнение, дошедшее до конца тела метода, возвращает None
+    EmitExit(RETURN_NONE);
+    for (size_t jump : deopt_jumps_) {
+        Bind(jump);
+    }
+    if (!deopt_jumps_.empty()) {
+        EmitExit(DEOPTIMIZE);
+    }
+    return std::move(code_);
+}
+
+void Emitter::Emit(std::initializer_list<std::uint8_t> bytes) {
+    const size_t offset = code_.size();
+    code_.resize(offset + bytes.size());
+    std::memcpy(code_.data() + offset, bytes.begin(), bytes.size());
+}
+
+void Emitter::EmitInt32(std::int32_t value) {
+    const size_t offset = code_.size();
+    code_.resize(offset + sizeof(value));
+    std::memcpy(code_.data() + offset, &value, sizeof(value));
+}
+
+void Emitter::EmitInt64(std::int64_t value) {
+    const size_t offset = code_.size();
+    code_.resize(offset + sizeof(value));
+    std::memcpy(code_.data() + offset, &value, sizeof(value));
+}
+
+void Emitter::EmitEpilogue() {
+    Emit({ 0x48, 0x89, 0xDC });  // mov rsp, rbx
+    Emit({ 0x41, 0x5F });        // pop r15
+    Emit({ 0x41, 0x5D });        // pop r13
+    Emit({ 0x41, 0x5C });        // pop r12
+    Emit({ 0x5B });              // pop rbx
+    Emit({ 0xC3 });              // ret
+}
+
+void Emitter::EmitExit(std::int32_t status) {
+    LoadConstant(status);
+    EmitEpilogue();
+}
+
+void Emitter::DeoptimizeIf(std::uint8_t condition) {
+    Emit({ 0x0F, condition });  // jcc deoptimize
+    deopt_jumps_.push_back(code_.size());
+    EmitInt32(0);
+}
+
+void Emitter::EmitCall(const void* function) {
+    Emit({ 0x48, 0xB8 });              // mov rax, imm64
+    EmitInt64(reinterpret_cast<std::intptr_t>(function));
+    Emit({ 0x49, 0x89, 0xE7 });        // mov r15, rsp
+    Emit({ 0x48, 0x83, 0xE4, 0xF0 });  // and rsp, -16
+    Emit({ 0xFF, 0xD0 });              // call rax
+    Emit({ 0x4C, 0x89, 0xFC });        // mov rsp, r15
+}
+
+void Emitter::DeoptimizeIfNoValue() {
+    Emit({ 0x48, 0x89, 0xC1 });        // mov rcx, rax
+    Emit({ 0x48, 0xC1, 0xE9, 0x20 });  // shr rcx, 32
+    DeoptimizeIf(JZ);
+}
+
+NativeCode::NativeCode(void* memory, size_t size, size_t param_count, size_t slot_count)
+    : memory_(memory)
+    , size_(size)
+    , param_count_(param_count)
+    , slot_count_(slot_count) {
+}
+
+NativeCode::~NativeCode() {
+#if MYTHON_JIT_SUPPORTED
+    munmap(memory_, size_);
+#endif
+}
+
+std::unique_ptr<NativeCode> NativeCode::Create(const std::vector<std::uint8_t>& code,
+    size_t param_count, size_t slot_count) {
+#if MYTHON_JIT_SUPPORTED
+    const size_t size = code.size();
+    void* memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (memory == MAP_FAILED) {
+        return nullptr;
+    }
+    std::memcpy(memory, code.data(), size);
+    // Страницы не бывают одновременно доступны для записи и исполнения
+    if (mprotect(memory, size, PROT_READ | PROT_EXEC) != 0) {
+        munmap(memory, size);
+        return nullptr;
+    }
+    return std::unique_ptr<NativeCode>(new NativeCode(memory, size, param_count, slot_count));
+#else
+    (void)code;
+    (void)param_count;
+    (void)slot_count;
+    return nullptr;
+#endif
+}
+
+std::optional<runtime::ObjectHolder> NativeCode::Run(const runtime::FrameSlot* frame) const {
+    if (!frame || !frame[0]) {
+        return std::nullopt;
+    }
+    auto* self = frame[0]->TryAs<runtime::ClassInstance>();
+    if (!self) {
+        return std::nullopt;
+    }
+    std::array<std::int32_t, MAX_PARAMS> args{};
+    for (size_t i = 0; i < param_count_; ++i) {
+        const runtime::FrameSlot& param = frame[i + 1];
+        if (!param || param->GetKind() != runtime::ObjectKind::NUMBER) {
+            return std::nullopt;
+        }
+        args[i] = param->GetNumber();
+    }
+
+    const std::optional<NativeResult> result = Call(*self, args.data());
+    if (!result) {
+        return std::nullopt;
+    }
+    switch (result->type) {
+    case ValueType::NUMBER:
+        return runtime::ObjectHolder::Own(runtime::Number(result->value));
+    case ValueType::BOOL:
+        return result->value != 0 ? runtime::ObjectHolder::True() : runtime::ObjectHolder::False();
+    default:
+        return runtime::ObjectHolder::None();
+    }
+}
+
+std::optional<NativeResult> NativeCode::Call(runtime::ClassInstance& self,
+    const std::int32_t* args) const {
+    std::array<std::int64_t, MAX_SLOTS> frame;
+    frame[0] = reinterpret_cast<std::intptr_t>(&self);
+    for (size_t i = 0; i < param_count_; ++i) {
+        frame[i + 1] = args[i];
+    }
+    std::fill(frame.begin() + param_count_ + 1, frame.begin() + slot_count_, UNDEFINED_SLOT);
+
+    std::int32_t result = 0;
+    switch (reinterpret_cast<Entry>(memory_)(frame.data(), &result)) {
+    case RETURN_NUMBER:
+        return NativeResult{ ValueType::NUMBER, result };
+    case RETURN_BOOL:
+        return NativeResult{ ValueType::BOOL, result };
+    case RETURN_NONE:
+        return NativeResult{ ValueType::NONE };
+    default:
+        return std::nullopt;
+    }
+}
+
+std::unique_ptr<NativeCode> Compile(ast::Statement& body, size_t param_count) {
+    if (!IsSupported() || param_count > MAX_PARAMS) {
+        return nullptr;
+    }
+    Emitter emitter(param_count);
+    if (body.EmitNative(emitter) == ValueType::UNSUPPORTED) {
+        return nullptr;
+    }
+    std::vector<std::uint8_t> code = emitter.Finish();
+    return NativeCode::Create(code, param_count, emitter.GetSlotCount());
+}
+
+}  // namespace jit
+
+// Трансляция узлов AST в машинный код
+
+namespace ast {
+
+using jit::ValueType;
+
+ValueType Statement::EmitNative([[maybe_unused]] jit::Emitter& emitter) {
+    return ValueType::UNSUPPORTED;
+}
+
+ValueType EmitNativeConstant(jit::Emitter& emitter, const runtime::Number& value) {
+    emitter.LoadConstant(value.GetValue());
+    return ValueType::NUMBER;
+}
+
+ValueType EmitNativeConstant(jit::Emitter& emitter, const runtime::Bool& value) {
+    emitter.LoadConstant(value.GetValue() ? 1 : 0);
+    return ValueType::BOOL;
+}
+
+ValueType VariableValue::EmitNative(jit::Emitter& emitter) {
+    if (slot_ == MethodScope::NO_SLOT) {
+        return ValueType::UNSUPPORTED;
+    }
+    if (field_path_.IsEmpty()) {
+        return emitter.LoadSlot(slot_);
+    }
+    // Параметры и локальные переменные машинного кода - числа либо Bool, поэтому цепочки
+    // полей читаются только у self. Повторное чтение цепочки снова обращается к полям:
+    // машинный код не изменяет поля, поэтому значение не меняется
+    if (slot_ != 0) {
+        return ValueType::UNSUPPORTED;
+    }
+    emitter.LoadField(field_path_);
+    return ValueType::NUMBER;
+}
+
+ValueType Assignment::EmitNative(jit::Emitter& emitter) {
+    if (slot_ == MethodScope::NO_SLOT) {
+        return ValueType::UNSUPPORTED;
+    }
+    const ValueType type = rv_->EmitNative(emitter);
+    if ((type != ValueType::NUMBER && type != ValueType::BOOL) || !emitter.StoreSlot(slot_, type)) {
+        return ValueType::UNSUPPORTED;
+    }
+    return ValueType::NONE;
+}
+
+ValueType MethodCall::EmitNative(jit::Emitter& emitter) {
+    // Получатель - self либо цепочка полей self
+    auto* object = dynamic_cast<VariableValue*>(object_.get());
+    if (!object || object->GetSlot() != 0) {
+        return ValueType::UNSUPPORTED;
+    }
+    emitter.LoadInstance(object->GetFieldPath());
+    return emitter.EmitMethodCall(*this, args_);
+}
+
+std::optional<std::int32_t> MethodCall::CallNative(runtime::ClassInstance& receiver,
+    const std::int32_t* args) {
+    // Класс, которого нет во встроенном кэше, сначала встречает обход AST
+    const auto* entry = cache_.Lookup(receiver.GetClass());
+    if (!entry) {
+        return std::nullopt;
+    }
+    if (const InlineMethod* inline_method = entry->data.inline_method) {
+        if (inline_method->kind != InlineMethod::Kind::GETTER) {
+            return std::nullopt;
+        }
+        const runtime::ObjectHolder* value = inline_method->path->ResolveCached(receiver);
+        if (!value || value->GetKind() != runtime::ObjectKind::NUMBER) {
+            return std::nullopt;
+        }
+        return value->GetNumber();
+    }
+    const jit::NativeCode* code = entry->data.body ? entry->data.body->GetNativeCode() : nullptr;
+    if (!code) {
+        return std::nullopt;
+    }
+    const std::optional<jit::NativeResult> result = code->Call(receiver, args);
+    if (!result || result->type != ValueType::NUMBER) {
+        return std::nullopt;
+    }
+    return result->value;
+}
+
+ValueType Add::EmitNative(jit::Emitter& emitter) {
+    return emitter.EmitArithmetic(*lhs_, *rhs_, jit::ArithmeticOp::ADD);
+}
+
+ValueType Sub::EmitNative(jit::Emitter& emitter) {
+    return emitter.EmitArithmetic(*lhs_, *rhs_, jit::ArithmeticOp::SUB);
+}
+
+ValueType Mult::EmitNative(jit::Emitter& emitter) {
+    return emitter.EmitArithmetic(*lhs_, *rhs_, jit::ArithmeticOp::MULT);
+}
+
+ValueType Div::EmitNative(jit::Emitter& emitter) {
+    return emitter.EmitArithmetic(*lhs_, *rhs_, jit::ArithmeticOp::DIV);
+}
+
+ValueType Comparison::EmitNative(jit::Emitter& emitter) {
+    switch (operator_) {
+    case Operator::LESS:
+        return emitter.EmitComparison(*lhs_, *rhs_, jit::CompareOp::LESS);
+    case Operator::GREATER:
+        return emitter.EmitComparison(*lhs_, *rhs_, jit::CompareOp::GREATER);
+    case Operator::EQUAL:
+        return emitter.EmitComparison(*lhs_, *rhs_, jit::CompareOp::EQUAL);
+    case Operator::NOT_EQUAL:
+        return emitter.EmitComparison(*lhs_, *rhs_, jit::CompareOp::NOT_EQUAL);
+    case Operator::LESS_OR_EQUAL:
+        return emitter.EmitComparison(*lhs_, *rhs_, jit::CompareOp::LESS_OR_EQUAL);
+    case Operator::GREATER_OR_EQUAL:
+        return emitter.EmitComparison(*lhs_, *rhs_, jit::CompareOp::GREATER_OR_EQUAL);
+    default:
+        return ValueType::UNSUPPORTED;
+    }
+}
+
+ValueType Compound::EmitNative(jit::Emitter& emitter) {
+    for (auto& argument : args_) {
+        if (argument->EmitNative(emitter) == ValueType::UNSUPPORTED) {
+            return ValueType::UNSUPPORTED;
+        }
+    }
+    return ValueType::NONE;
+}
+
+ValueType Return::EmitNative(jit::Emitter& emitter) {
+    const ValueType type = statement_->EmitNative(emitter);
+    if (type != ValueType::NUMBER && type != ValueType::BOOL) {
+        return ValueType::UNSUPPORTED;
+    }
+    emitter.Return(type);
+    return ValueType::NONE;
+}
+
+ValueType ReturnVariable::EmitNative(jit::Emitter& emitter) {
+    const ValueType type = variable_.EmitNative(emitter);
+    if (type != ValueType::NUMBER && type != ValueType::BOOL) {
+        return ValueType::UNSUPPORTED;
+    }
+    emitter.Return(type);
+    return ValueType::NONE;
+}
+
+ValueType IfElse::EmitNative(jit::Emitter& emitter) {
+    const ValueType condition = condition_->EmitNative(emitter);
+    if (condition != ValueType::NUMBER && condition != ValueType::BOOL) {
+        return ValueType::UNSUPPORTED;
+    }
+    const size_t else_branch = emitter.JumpIfFalse();
+    if (if_body_->EmitNative(emitter) == ValueType::UNSUPPORTED) {
+        return ValueType::UNSUPPORTED;
+    }
+    const size_t end = emitter.Jump();
+    emitter.Bind(else_branch);
+    if (else_body_ && else_body_->EmitNative(emitter) == ValueType::UNSUPPORTED) {
+        return ValueType::UNSUPPORTED;
+    }
+    emitter.Bind(end);
+    return ValueType::NONE;
+}
+
+}  // namespace ast
@@ -0,0 +1,196 @@
+#pragma once
+
+#include "runtime.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <vector>
+
+namespace ast {
+class FieldPath;
+class MethodCall;
+class Statement;
+}  // namespace ast
+
+namespace jit {
+
+// Количество вызовов тела метода, после которого оно транслируется в машинный код
+constexpr size_t HOT_CALL_THRESHOLD = 1000;
+
+// Наибольшее количество параметров метода, который транслируется в машинный код
+constexpr size_t MAX_PARAMS = 8;
+
+// Наибольшее количество слотов фрейма (self, параметры и локальные переменные) метода,
+// который транслируется в машинный код
+constexpr size_t MAX_SLOTS = 32;
+
+// Тип значения, которое код узла оставляет в регистре результата
+enum class ValueType : std::uint8_t {
+    UNSUPPORTED,  // узел не транслируется в машинный код
+    NUMBER,
+    BOOL,
+    NONE,  // инструкция, не оставляющая значения
+};
+
+enum class ArithmeticOp : std::uint8_t {
+    ADD,
+    SUB,
+    MULT,
+    DIV,
+};
+
+enum class CompareOp : std::uint8_t {
+    LESS,
+    GREATER,
+    EQUAL,
+    NOT_EQUAL,
+    LESS_OR_EQUAL,
+    GREATER_OR_EQUAL,
+};
+
+// Возвращает true, если на этой платформе тела методов транслируются в машинный код
+[[nodiscard]] bool IsSupported();
+
+/*
+Формирует машинный код x86-64 тела метода. Машинный код получает фрейм - массив слотов
+int64_t: в слоте 0 хранится адрес объекта self, в остальных - значения параметров и локальных
+переменных (числа либо Bool). Результат вычисления выражения хранится в регистре eax.
+Поля объектов машинный код читает, а методы вызывает через функции-помощники из jit.cpp.
+Узлы AST добавляют свой код методом Statement::EmitNative.
+
+Машинный код не изменяет объекты программы и не выводит данные, поэтому при деоптимизации
+метод можно выполнить обходом AST с самого начала
+*/
+class Emitter {
+public:
+    explicit Emitter(size_t param_count);
+
+    // Загружает в регистр результата число value
+    void LoadConstant(std::int32_t value);
+
+    // Загружает в регистр результата значение параметра либо локальной переменной из слота
+    // фрейма slot и возвращает его тип. Если переменной ещё не присвоено значение,
+    // метод выполняется обходом AST. Возвращает ValueType::UNSUPPORTED для слота self
+    // и для переменных, которым не присваивались числа либо Bool
+    ValueType LoadSlot(size_t slot);
+
+    // Записывает значение регистра результата типа type в слот фрейма slot.
+    // Возвращает false, если слот занимает self либо переменной уже присваивались
+    // значения другого типа
+    bool StoreSlot(size_t slot, ValueType type);
+
+    // Загружает в регистр результата число - значение цепочки полей path объекта self.
+    // Если форма объекта цепочки отличается от запомненной в path либо значение - не число,
+    // метод выполняется обходом AST
+    void LoadField(ast::FieldPath& path);
+
+    // Загружает в регистр результата адрес экземпляра класса - значения цепочки полей path
+    // объекта self (либо самого self для пустой цепочки)
+    void LoadInstance(ast::FieldPath& path);
+
+    // Добавляет вызов метода узлом call для объекта, адрес которого находится в регистре
+    // результата, с аргументами-числами args. Метод ищется во встроенном кэше узла call
+    // (см. ast::MethodCall::CallNative)
+    ValueType EmitMethodCall(ast::MethodCall& call,
+        const std::vector<std::unique_ptr<ast::Statement>>& args);
+
+    // Добавляет код арифметической операции над числами lhs и rhs
+    ValueType EmitArithmetic(ast::Statement& lhs, ast::Statement& rhs, ArithmeticOp op);
+
+    // Добавляет код сравнения чисел lhs и rhs
+    ValueType EmitComparison(ast::Statement& lhs, ast::Statement& rhs, CompareOp op);
+
+    // Добавляет переход, выполняемый, если регистр результата содержит 0 (False).
+    // Возвращает номер перехода для Bind
+    size_t JumpIfFalse();
+
+    // Добавляет безусловный переход. Возвращает номер перехода для Bind
+    size_t Jump();
+
+    // Направляет переход jump на следующую добавляемую инструкцию
+    void Bind(size_t jump);
+
+    // Завершает выполнение машинного кода, возвращая значение регистра результата типа type
+    void Return(ValueType type);
+
+    // Завершает формирование кода и возвращает его
+    std::vector<std::uint8_t> Finish();
+
+    // Возвращает количество слотов фрейма, к которым обращается код
+    [[nodiscard]] size_t GetSlotCount() const {
+        return slot_types_.size();
+    }
+
+private:
+    void Emit(std::initializer_list<std::uint8_t> bytes);
+    void EmitInt32(std::int32_t value);
+    void EmitInt64(std::int64_t value);
+    void EmitEpilogue();
+    void EmitExit(std::int32_t status);
+
+    // Добавляет условный переход к деоптимизации. condition - второй байт команды jcc rel32
+    void DeoptimizeIf(std::uint8_t condition);
+
+    // Вызывает функцию-помощник function, выравнивая стек по требованию соглашения о вызовах
+    void EmitCall(const void* function);
+
+    // Переходит к деоптимизации, если функция-помощник не вернула значение (см. PackNumber)
+    void DeoptimizeIfNoValue();
+
+    // Вычисляет lhs и rhs: значение lhs оказывается в eax, значение rhs - в ecx.
+    // Возвращает false, если аргументы не числа
+    bool EmitOperands(ast::Statement& lhs, ast::Statement& rhs);
+
+    std::vector<std::uint8_t> code_;
+    size_t param_count_;
+    // Типы значений в слотах фрейма. UNSUPPORTED - слоту ещё не присваивалось значение
+    std::vector<ValueType> slot_types_;
+    // Переходы к деоптимизации (возврату к обходу AST)
+    std::vector<size_t> deopt_jumps_;
+};
+
+// Значение, которое вернул машинный код
+struct NativeResult {
+    ValueType type;  // NUMBER, BOOL либо NONE
+    std::int32_t value = 0;
+};
+
+// Машинный код тела метода, размещённый в исполняемых страницах памяти
+class NativeCode {
+public:
+    NativeCode(const NativeCode&) = delete;
+    NativeCode& operator=(const NativeCode&) = delete;
+    ~NativeCode();
+
+    // Размещает code в исполняемой памяти. Код обращается к slot_count слотам фрейма.
+    // Возвращает nullptr, если это не удалось
+    static std::unique_ptr<NativeCode> Create(const std::vector<std::uint8_t>& code,
+        size_t param_count, size_t slot_count);
+
+    // Выполняет код с параметрами из слотов frame. Возвращает std::nullopt, если выполнение
+    // нужно продолжить обходом AST: параметры не числа либо код выполнил деоптимизацию
+    [[nodiscard]] std::optional<runtime::ObjectHolder> Run(const runtime::FrameSlot* frame) const;
+
+    // Выполняет код для объекта self с param_count параметрами-числами args.
+    // Возвращает std::nullopt, если код выполнил деоптимизацию
+    [[nodiscard]] std::optional<NativeResult> Call(runtime::ClassInstance& self,
+        const std::int32_t* args) const;
+
+private:
+    using Entry = std::int32_t (*)(std::int64_t* frame, std::int32_t* result);
+
+    NativeCode(void* memory, size_t size, size_t param_count, size_t slot_count);
+
+    void* memory_;
+    size_t size_;
+    size_t param_count_;
+    size_t slot_count_;
+};
+
+// Транслирует тело метода с param_count параметрами в машинный код.
+// Возвращает nullptr, если тело содержит узлы, которые не транслируются
+std::unique_ptr<NativeCode> Compile(ast::Statement& body, size_t param_count);
+
+}  // namespace jit
@@ -0,0 +1,228 @@
+#include "jit.h"
+#include "lexer.h"
+#include "parse.h"
+#include "statement.h"
+
+#include <test_runner.h>
+
+using namespace std;
+
+namespace jit {
+
+namespace {
+
+const string PROGRAM = R"(
+class Math:
+  def poly(x):
+    return 3 * x * x - 2 * x + 1
+
+  def sign(x):
+    if x > 0:
+      return 1
+    else:
+      if x < 0:
+        return -1
+    return 0
+
+  def ratio(x, y):
+    return x / y
+
+  def is_even(x):
+    return x / 2 * 2 == x
+
+  def double(x):
+    return x + x
+
+  def twice(x):
+    return self.double(x)
+
+  def fib(n):
+    if n < 2:
+      return n
+    return self.fib(n - 1) + self.fib(n - 2)
+
+class Triple(Math):
+  def double(x):
+    return x * 3
+
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+class Flipped:
+  def __init__(x, y):
+    self.y = y
+    self.x = x
+
+class Segment:
+  def __init__(a, b):
+    self.a = a
+    self.b = b
+
+  def length2():
+    dx = self.b.x - self.a.x
+    dy = self.b.y - self.a.y
+    return dx * dx + dy * dy
+
+  def is_long(limit):
+    long = self.length2() > limit * limit
+    return long
+
+m = Math()
+t = Triple()
+s = Segment(Point(1, 2), Point(4, 6))
+f = Segment(Point(0, 0), Flipped(6, 8))
+)"s;
+
+// Выполняет программу PROGRAM и вызывает методы созданных ею объектов.
+// По умолчанию методы вызываются у объекта m
+class MathFixture {
+public:
+    MathFixture() {
+        istringstream is(PROGRAM);
+        parse::Lexer lexer(is);
+        program_ = ParseProgram(lexer);
+        program_->Execute(closure_, context_);
+    }
+
+    runtime::ObjectHolder Call(const string& method, vector<int> args,
+        const string& object = "m"s) {
+        vector<runtime::ObjectHolder> actual_args;
+        for (int arg : args) {
+            actual_args.push_back(runtime::ObjectHolder::Own(runtime::Number(arg)));
+        }
+        return GetInstance(object).Call(method, actual_args, context_);
+    }
+
+    runtime::ObjectHolder CallWith(const string& method, vector<runtime::ObjectHolder> args) {
+        return GetInstance("m"s).Call(method, args, context_);
+    }
+
+    // Вызывает метод столько раз, сколько нужно для трансляции в машинный код
+    void Warm(const string& method, vector<int> args, const string& object = "m"s) {
+        for (size_t i = 0; i < HOT_CALL_THRESHOLD; ++i) {
+            Call(method, args, object);
+        }
+    }
+
+    [[nodiscard]] bool IsNative(const string& method, size_t argument_count,
+        const string& object = "m"s) {
+        const runtime::Method* m
+            = GetInstance(object).GetClass().GetMethod(method, argument_count);
+        return dynamic_cast<const ast::MethodBody&>(*m->body).IsNative();
+    }
+
+private:
+    runtime::ClassInstance& GetInstance(const string& object) {
+        return closure_.at(object).As<runtime::ClassInstance>();
+    }
+
+    unique_ptr<ast::Statement> program_;
+    runtime::Closure closure_;
+    runtime::DummyContext context_;
+};
+
+int GetNumber(const runtime::ObjectHolder& object) {
+    return object.GetNumber();
+}
+
+}  // namespace
+
+void TestNativeArithmetic() {
+    MathFixture math;
+    ASSERT(!math.IsNative("poly"s, 1));
+    math.Warm("poly"s, {2});
+    math.Warm("ratio"s, {7, 2});
+    ASSERT_EQUAL(math.IsNative("poly"s, 1), IsSupported());
+    ASSERT_EQUAL(math.IsNative("ratio"s, 2), IsSupported());
+
+    for (int x : {-7, -1, 0, 1, 2, 1000}) {
+        ASSERT_EQUAL(GetNumber(math.Call("poly"s, {x})), 3 * x * x - 2 * x + 1);
+    }
+    ASSERT_EQUAL(GetNumber(math.Call("ratio"s, {7, 2})), 3);
+    ASSERT_EQUAL(GetNumber(math.Call("ratio"s, {-7, 2})), -3);
+    ASSERT_EQUAL(GetNumber(math.Call("ratio"s, {7, -1})), -7);
+}
+
+void TestNativeBranches() {
+    MathFixture math;
+    math.Warm("sign"s, {5});
+    math.Warm("is_even"s, {5});
+    ASSERT_EQUAL(math.IsNative("sign"s, 1), IsSupported());
+    ASSERT_EQUAL(math.IsNative("is_even"s, 1), IsSupported());
+
+    ASSERT_EQUAL(GetNumber(math.Call("sign"s, {42})), 1);
+    ASSERT_EQUAL(GetNumber(math.Call("sign"s, {-42})), -1);
+    ASSERT_EQUAL(GetNumber(math.Call("sign"s, {0})), 0);
+    ASSERT(runtime::IsTrue(math.Call("is_even"s, {4})));
+    ASSERT(math.Call("is_even"s, {4}).TryAs<runtime::Bool>() != nullptr);
+    ASSERT(!runtime::IsTrue(math.Call("is_even"s, {5})));
+}
+
+void TestDeoptimization() {
+    MathFixture math;
+    math.Warm("double"s, {1});
+    math.Warm("ratio"s, {1, 1});
+
+    // Аргументы других типов передаются обходу AST
+    const auto text = runtime::ObjectHolder::Own(runtime::String("ab"s));
+    ASSERT_EQUAL(math.CallWith("double"s, {text}).As<runtime::String>().GetValue(), "abab"s);
+    ASSERT_EQUAL(GetNumber(math.Call("double"s, {21})), 42);
+
+    // Ошибку деления на 0 сообщает обход AST
+    try {
+        math.Call("ratio"s, {1, 0});
+        ASSERT(false);
+    } catch (const runtime_error& e) {
+        ASSERT_EQUAL(string(e.what()), "Failed to divide by 0, can't deal with eternity"s);
+    }
+    ASSERT_EQUAL(GetNumber(math.Call("ratio"s, {9, 3})), 3);
+}
+
+void TestNativeMethodCalls() {
+    MathFixture math;
+    math.Warm("fib"s, {10});
+    math.Warm("twice"s, {1});
+    ASSERT_EQUAL(math.IsNative("fib"s, 1), IsSupported());
+    ASSERT_EQUAL(math.IsNative("twice"s, 1), IsSupported());
+    // Вызываемый метод транслируется при первом вызове из машинного кода
+    ASSERT_EQUAL(math.IsNative("double"s, 1), IsSupported());
+
+    ASSERT_EQUAL(GetNumber(math.Call("fib"s, {20})), 6765);
+    ASSERT_EQUAL(GetNumber(math.Call("twice"s, {4})), 8);
+
+    // Класса Triple нет во встроенном кэше места вызова self.double: первый вызов выполняет
+    // обход AST, который дополняет кэш, а следующие - машинный код
+    ASSERT_EQUAL(GetNumber(math.Call("twice"s, {4}, "t"s)), 12);
+    ASSERT_EQUAL(GetNumber(math.Call("twice"s, {5}, "t"s)), 15);
+    ASSERT_EQUAL(GetNumber(math.Call("twice"s, {5})), 10);
+}
+
+void TestNativeFieldLoads() {
+    MathFixture math;
+    math.Warm("length2"s, {}, "s"s);
+    math.Warm("is_long"s, {3}, "s"s);
+    ASSERT_EQUAL(math.IsNative("length2"s, 0, "s"s), IsSupported());
+    ASSERT_EQUAL(math.IsNative("is_long"s, 1, "s"s), IsSupported());
+
+    ASSERT_EQUAL(GetNumber(math.Call("length2"s, {}, "s"s)), 25);
+    ASSERT(runtime::IsTrue(math.Call("is_long"s, {4}, "s"s)));
+    ASSERT(!runtime::IsTrue(math.Call("is_long"s, {5}, "s"s)));
+
+    // Flipped задаёт поля в другом порядке, поэтому его форма отличается от формы Point,
+    // запомненной цепочкой полей, и поля читает обход AST
+    ASSERT_EQUAL(GetNumber(math.Call("length2"s, {}, "f"s)), 100);
+    ASSERT(runtime::IsTrue(math.Call("is_long"s, {9}, "f"s)));
+    ASSERT_EQUAL(GetNumber(math.Call("length2"s, {}, "s"s)), 25);
+}
+
+void RunUnitTests(TestRunner& tr) {
+    RUN_TEST(tr, jit::TestNativeArithmetic);
+    RUN_TEST(tr, jit::TestNativeBranches);
+    RUN_TEST(tr, jit::TestDeoptimization);
+    RUN_TEST(tr, jit::TestNativeMethodCalls);
+    RUN_TEST(tr, jit::TestNativeFieldLoads);
+}
+
+}  // namespace jit
@@ -1,10 +1,14 @@
+#include "aot.h"
+#include "flat.h"
 #include "lexer.h"
 #include "parse.h"
 #include "runtime.h"
 #include "statement.h"
 #include "test_runner.h"
+#include "vm.h"
 
 #include <iostream>
+#include <string_view>
 
 using namespace std;
 
@@ -20,17 +24,59 @@ void RunObjectHolderTests(TestRunner& tr);
 void RunObjectsTests(TestRunner& tr);
 }  // namespace runtime
 
+namespace vm {
+void RunUnitTests(TestRunner& tr);
+}  // namespace vm
+
+namespace jit {
+void RunUnitTests(TestRunner& tr);
+}  // namespace jit
+
+namespace aot {
+void RunUnitTests(TestRunner& tr);
+}  // namespace aot
+
+namespace flat {
+void RunUnitTests(TestRunner& tr);
+}  // namespace flat
+
 void TestParseProgram(TestRunner& tr);
 
 namespace {
 
-void RunMythonProgram(istream& input, ostream& output) {
+// Способ выполнения программы
+enum class Engine {
+    AST,       // обход абстрактного синтаксического дерева
+    BYTECODE,  // трансляция в байт-код и выполнение виртуальной машиной
+    FLAT,      // перевод в дерево с узлами в непрерывном массиве и выполнение switch по видам узлов
+};
+
+void RunMythonProgram(istream& input, ostream& output, Engine engine = Engine::AST) {
     parse::Lexer lexer(input);
     auto program = ParseProgram(lexer);
 
     runtime::SimpleContext context{output};
-    runtime::Closure closure;
-    program->Execute(closure, context);
+    if (engine == Engine::BYTECODE) {
+        vm::Program compiled(*program);
+        runtime::Closure closure;
+        compiled.Execute(closure, context);
+    }
+    else if (engine == Engine::FLAT) {
+        flat::Program flattened(*program);
+        runtime::Closure closure;
+        flattened.Execute(closure, context);
+    }
+    else {
+        runtime::Closure closure;
+        program->Execute(closure, context);
+    }
+}
+
+// Транслирует программу из input в программу на C++ и выводит её исходный текст в output
+void TranslateMythonProgram(istream& input, ostream& output) {
+    parse::Lexer lexer(input);
+    auto program = ParseProgram(lexer);
+    output << aot::Translate(*program);
 }
 
 void TestSimplePrints() {
@@ -118,6 +164,10 @@ void TestAll() {
     runtime::RunObjectsTests(tr);
     ast::RunUnitTests(tr);
     TestParseProgram(tr);
+    vm::RunUnitTests(tr);
+    jit::RunUnitTests(tr);
+    aot::RunUnitTests(tr);
+    flat::RunUnitTests(tr);
 
     RUN_TEST(tr, TestSimplePrints);
     RUN_TEST(tr, TestAssignments);
@@ -127,11 +177,39 @@ void TestAll() {
 
 }  // namespace
 
-int main() {
+int main(int argc, char* argv[]) {
+    Engine engine = Engine::AST;
+    bool translate = false;
+    for (int i = 1; i < argc; ++i) {
+        const string_view arg = argv[i];
+        if (arg == "--engine=ast"sv) {
+            engine = Engine::AST;
+        }
+        else if (arg == "--engine=vm"sv) {
+            engine = Engine::BYTECODE;
+        }
+        else if (arg == "--engine=flat"sv) {
+            engine = Engine::FLAT;
+        }
+        else if (arg == "--aot"sv) {
+            translate = true;
+        }
+        else {
+            cerr << "Unknown option "sv << arg
+                 << ". Usage: mython [--engine=ast|vm|flat] [--aot]"sv << endl;
+            return 1;
+        }
+    }
+
     try {
         TestAll();
 
-        RunMythonProgram(cin, cout);
+        if (translate) {
+            TranslateMythonProgram(cin, cout);
+        }
+        else {
+            RunMythonProgram(cin, cout, engine);
+        }
     } catch (const std::exception& e) {
         std::cerr << e.what() << std::endl;
 		return 1;
@@ -30,6 +30,8 @@ public:
         while (!lexer_.CurrentToken().Is<TokenType::Eof>()) {
             result->AddStatement(ParseStatement());
         }
+        result->Fold();
+        result->Fuse();
 
         return result;
     }
@@ -76,7 +78,16 @@ private:
             lexer_.ExpectNext<TokenType::Char>(':');
             lexer_.NextToken();
 
-            m.body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            auto body = std::make_unique<ast::MethodBody>(ParseSuite());  // NOLINT
+            // Константные выражения вычисляются один раз, до выполнения программы
+            body->Fold();
+            // Параметры, self и локальные переменные метода хранятся в слотах фрейма вызова
+            m.frame_size = body->ResolveFrame(m.formal_params);
+            // Частые сочетания узлов тела метода заменяются суперинструкциями
+            body->Fuse();
+            // Повторные чтения цепочек полей берут значение из скрытых слотов фрейма
+            m.frame_size = body->ShareRepeatedFieldChains(m.frame_size);
+            m.body = std::move(body);
 
             result.push_back(std::move(m));
         }
@@ -443,6 +454,6 @@ private:
 
 }  // namespace
 
-unique_ptr<runtime::Executable> ParseProgram(parse::Lexer& lexer) {
+unique_ptr<ast::Statement> ParseProgram(parse::Lexer& lexer) {
     return Parser{lexer}.ParseProgram();
 }
@@ -3,23 +3,123 @@
 #include <cassert>
 #include <optional>
 #include <sstream>
-#include <algorithm>
 
 using namespace std;
 
 namespace runtime {
 
-ObjectHolder::ObjectHolder(std::shared_ptr<Object> data)
-    : data_(std::move(data)) {
+namespace {
+const string SELF_NAME = "self"s;
+
+// Имена специальных методов в порядке элементов SpecialMethod
+const string_view SPECIAL_METHOD_NAMES[SPECIAL_METHOD_COUNT] = {
+    "__init__"sv, "__str__"sv, "__eq__"sv, "__lt__"sv, "__add__"sv,
+    "__gt__"sv, "__le__"sv, "__ge__"sv, "__ne__"sv,
+};
+
+// Общие для всего интерпретатора объекты Number со значениями
+// от SMALL_NUMBER_MIN до SMALL_NUMBER_MAX. Не удаляются до завершения программы
+Number* SmallNumbers() {
+    static Number* const numbers = [] {
+        auto* result = new vector<Number>();
+        result->reserve(SMALL_NUMBER_MAX - SMALL_NUMBER_MIN + 1);
+        for (int n = SMALL_NUMBER_MIN; n <= SMALL_NUMBER_MAX; ++n) {
+            result->emplace_back(n);
+        }
+        return result->data();
+    }();
+    return numbers;
+}
+}  // namespace
+
+FrameStack::~FrameStack() = default;
+
+FrameSlot* FrameStack::Push(size_t size, Mark& mark) {
+    mark = { block_, top_ };
+    if (block_ < blocks_.size() && top_ + size <= blocks_[block_].size) {
+        FrameSlot* frame = blocks_[block_].slots.get() + top_;
+        top_ += size;
+        return frame;
+    }
+
+    // Текущий блок заполнен: фрейм размещается в начале следующего блока
+    size_t next = blocks_.empty() ? 0 : block_ + 1;
+    if (next == blocks_.size()) {
+        blocks_.emplace_back();
+    }
+    Block& block = blocks_[next];
+    if (block.size < size) {
+        block.size = std::max(size, BLOCK_SIZE);
+        block.slots = std::make_unique<FrameSlot[]>(block.size);
+    }
+    block_ = next;
+    top_ = size;
+    return block.slots.get();
+}
+
+void FrameStack::Pop(FrameSlot* frame, size_t size, const Mark& mark) {
+    for (size_t i = 0; i < size; ++i) {
+        frame[i].reset();
+    }
+    block_ = mark.block;
+    top_ = mark.top;
+}
+
+ObjectHolder::ObjectHolder(Object* data) noexcept
+    : kind_(Kind::OBJECT) {
+    object_ = data;
+    AddRef(object_);
+}
+
+ObjectHolder::ObjectHolder(Number value) noexcept {
+    const int n = value.GetValue();
+    if (n >= SMALL_NUMBER_MIN && n <= SMALL_NUMBER_MAX) {
+        kind_ = Kind::BORROWED;
+        object_ = &SmallNumbers()[static_cast<size_t>(n - SMALL_NUMBER_MIN)];
+    }
+    else {
+        kind_ = Kind::NUMBER;
+        number_ = n;
+    }
+}
+
+ObjectHolder::ObjectHolder(Bool value) noexcept
+    : ObjectHolder(value.GetValue() ? True() : False()) {
+}
+
+ObjectHolder ObjectHolder::Immortal(const Object& object) noexcept {
+    // Неуничтожаемые объекты не изменяются, поэтому их можно передавать как Object&
+    return Share(const_cast<Object&>(object));
+}
+
+ObjectHolder ObjectHolder::True() noexcept {
+    static const Bool* const true_object = new Bool(true);
+    return Immortal(*true_object);
+}
+
+ObjectHolder ObjectHolder::False() noexcept {
+    static const Bool* const false_object = new Bool(false);
+    return Immortal(*false_object);
 }
 
 void ObjectHolder::AssertIsValid() const {
-    assert(data_ != nullptr);
+    assert(kind_ != Kind::NONE);
 }
 
-ObjectHolder ObjectHolder::Share(Object& object) {
-    // Возвращаем невладеющий shared_ptr (его deleter ничего не делает)
-    return ObjectHolder(std::shared_ptr<Object>(&object, [](auto* /*p*/) { /* do nothing */ }));
+void ObjectHolder::Box() {
+    // Небольшие числа хранятся как ссылки на общие объекты, поэтому здесь всегда нужен
+    // новый объект. Копии ObjectHolder, сделанные после этого, ссылаются на него же
+    const int value = number_;
+    object_ = new Number(value);
+    AddRef(object_);
+    kind_ = Kind::OBJECT;
+}
+
+ObjectHolder ObjectHolder::Share(Object& object) noexcept {
+    ObjectHolder result;
+    result.object_ = &object;
+    result.kind_ = Kind::BORROWED;
+    return result;
 }
 
 ObjectHolder ObjectHolder::None() {
@@ -31,46 +131,51 @@ Object& ObjectHolder::operator*() const {
     return *Get();
 }
 
-Object* ObjectHolder::operator->() const {
+Object& ObjectHolder::operator*() {
     AssertIsValid();
-    return Get();
+    return *Get();
 }
 
-Object* ObjectHolder::Get() const {
-    return data_.get();
+Object* ObjectHolder::operator->() const {
+    AssertIsValid();
+    return Get();
 }
 
-ObjectHolder::operator bool() const {
-    return Get() != nullptr;
+Object* ObjectHolder::operator->() {
+    AssertIsValid();
+    return Get();
 }
 
 bool IsTrue(const ObjectHolder& object) {
-    if (object) {
-        if (const Bool* ptr = object.TryAs<Bool>();
-            ptr != nullptr) {
-            return ptr->GetValue();
-        }
-        else if (const String* ptr = object.TryAs<String>();
-            ptr != nullptr) {
-            return !ptr->GetValue().empty();
-        }
-        else if (const Number* ptr = object.TryAs<Number>();
-            ptr != nullptr) {
-            return ptr->GetValue() != 0;
-        }
-        else {
-            return false;
-        }
-    }
-    else {
+    switch (object.GetKind()) {
+    case ObjectKind::BOOL:
+        return object.As<Bool>().GetValue();
+    case ObjectKind::STRING:
+        return !object.As<String>().GetValue().empty();
+    case ObjectKind::NUMBER:
+        return object.GetNumber() != 0;
+    default:
         return false;
     }
 }
 
+void PrintValue(const ObjectHolder& object, std::ostream& os, Context& context) {
+    switch (object.GetKind()) {
+    case ObjectKind::NONE:
+        os << "None"sv;
+        break;
+    case ObjectKind::NUMBER:
+        os << object.GetNumber();
+        break;
+    default:
+        object->Print(os, context);
+        break;
+    }
+}
+
 void ClassInstance::Print(std::ostream& os, [[maybe_unused]] Context& context) {
-    if (HasMethod("__str__"s, 0)) {
-        ObjectHolder object = Call("__str__"s, {}, context);
-        object.Get()->Print(os, context);
+    if (const Method* str_method = cls_.GetSpecialMethod(SpecialMethod::STR, 0)) {
+        PrintValue(Call(*str_method, {}, context), os, context);
     }
     else {
         os << this;
@@ -78,42 +183,99 @@ void ClassInstance::Print(std::ostream& os, [[maybe_unused]] Context& context) {
 }
 
 bool ClassInstance::HasMethod(const std::string& method, size_t argument_count) const {
-    const Method* m = cls_.GetMethod(method);
-    if (m) {
-        return m->formal_params.size() == argument_count;
+    return cls_.GetMethod(method, argument_count) != nullptr;
+}
+
+ObjectHolder* ClassInstance::FindField(const std::string& name) {
+    if (fields_) {
+        auto it = fields_->find(name);
+        return it != fields_->end() ? &it->second : nullptr;
+    }
+    size_t slot = shape_->FindSlot(name);
+    return slot != Shape::NO_SLOT ? &slots_[slot] : nullptr;
+}
+
+const ObjectHolder* ClassInstance::FindField(const std::string& name) const {
+    return const_cast<ClassInstance*>(this)->FindField(name);
+}
+
+ObjectHolder& ClassInstance::SetField(const std::string& name, ObjectHolder value) {
+    if (fields_) {
+        ObjectHolder& field = (*fields_)[name];
+        field = std::move(value);
+        return field;
+    }
+    size_t slot = shape_->FindSlot(name);
+    if (slot == Shape::NO_SLOT) {
+        shape_ = shape_->AddField(name);
+        slot = slots_.size();
+        slots_.push_back(std::move(value));
     }
     else {
-        return false;
+        slots_[slot] = std::move(value);
+    }
+    return slots_[slot];
+}
+
+const Shape* ClassInstance::GetShape() const {
+    return fields_ ? nullptr : shape_;
+}
+
+Closure& ClassInstance::ToDictionary() const {
+    if (!fields_) {
+        fields_ = std::make_unique<Closure>();
+        const auto& names = shape_->GetFieldNames();
+        for (size_t i = 0; i < slots_.size(); ++i) {
+            fields_->emplace(names[i], std::move(slots_[i]));
+        }
+        slots_.clear();
+        slots_.shrink_to_fit();
     }
+    return *fields_;
 }
 
 Closure& ClassInstance::Fields() {
-    return closure_;
+    return ToDictionary();
 }
 
 const Closure& ClassInstance::Fields() const {
-    return closure_;
+    return ToDictionary();
 }
 
 ClassInstance::ClassInstance(const Class& cls)
-    :cls_(cls)
+    :Object(ObjectKind::CLASS_INSTANCE)
+    , cls_(cls)
+    , shape_(&cls.GetRootShape())
 {
 }
 
+size_t Shape::FindSlot(const std::string& name) const {
+    auto it = slots_.find(name);
+    return it != slots_.end() ? it->second : NO_SLOT;
+}
+
+Shape* Shape::AddField(const std::string& name) const {
+    auto& next = transitions_[name];
+    if (!next) {
+        next = std::make_unique<Shape>();
+        next->names_ = names_;
+        next->names_.push_back(name);
+        next->slots_ = slots_;
+        next->slots_.emplace(name, names_.size());
+    }
+    return next.get();
+}
+
+const std::vector<std::string>& Shape::GetFieldNames() const {
+    return names_;
+}
+
 ObjectHolder ClassInstance::Call(const std::string& method,
     const std::vector<ObjectHolder>& actual_args,
     [[maybe_unused]] Context& context) {
 
-    if (HasMethod(method, actual_args.size())) {
-        Closure closure;
-        closure["self"s] = ObjectHolder::Share(*this);
-
-        const Method* m = cls_.GetMethod(method);
-        for (size_t i = 0; i < actual_args.size(); ++i) {
-            closure[m->formal_params[i]] = actual_args[i];
-        }
-
-        return m->body.get()->Execute(closure, context);
+    if (const Method* m = cls_.GetMethod(method, actual_args.size())) {
+        return Call(*m, actual_args, context);
     }
     else {
         throw std::runtime_error("Method not found"s);
@@ -121,35 +283,86 @@ ObjectHolder ClassInstance::Call(const std::string& method,
 
 }
 
+ObjectHolder ClassInstance::Call(const Method& method,
+    const std::vector<ObjectHolder>& actual_args, Context& context) {
+    assert(method.formal_params.size() == actual_args.size());
+    StackFrame frame(context.GetFrameStack(), GetFrameSize(method));
+    for (size_t i = 0; i < actual_args.size(); ++i) {
+        frame[i + 1] = actual_args[i];
+    }
+    return CallInFrame(method, frame.Get(), context);
+}
+
+ObjectHolder ClassInstance::CallInFrame(const Method& method, FrameSlot* frame,
+    Context& context) {
+    // Слот 0 занимает self, за ним следуют параметры
+    frame[0] = ObjectHolder::Share(*this);
+    if (method.frame_size > 0) {
+        FrameScope frame_scope(context, frame);
+        Closure closure;
+        return method.body.get()->Execute(closure, context);
+    }
+
+    Closure closure;
+    closure[SELF_NAME] = ObjectHolder::Share(*this);
+
+    for (size_t i = 0; i < method.formal_params.size(); ++i) {
+        closure[method.formal_params[i]] = std::move(*frame[i + 1]);
+    }
+
+    return method.body.get()->Execute(closure, context);
+}
+
+const Class& ClassInstance::GetClass() const {
+    return cls_;
+}
+
 Class::Class(std::string name, std::vector<Method> methods, const Class* parent)
-    :name_(std::move(name))
+    :Object(ObjectKind::CLASS)
+    , name_(std::move(name))
     , methods_(std::move(methods))
     , parent_(parent)
 {
-}
-
-const Method* Class::GetMethod(const std::string& name) const {
-    auto comp = [&name](const Method& m) {
-        return m.name == name;
-    };
-    auto m_ptr = std::find_if(methods_.begin(), methods_.end(), comp);
-    if (m_ptr != methods_.end()) {
-        return &(*m_ptr);
+    // Собственные методы класса перекрывают одноимённые методы предков
+    for (const Method& m : methods_) {
+        method_table_.emplace(m.name, &m);
     }
-    else {
-        if (parent_) {
-            return parent_->GetMethod(name);
-        }
-        else {
-            return nullptr;
+    if (parent_) {
+        for (const auto& [method_name, m] : parent_->method_table_) {
+            method_table_.emplace(method_name, m);
         }
     }
+    for (size_t i = 0; i < SPECIAL_METHOD_COUNT; ++i) {
+        special_methods_[i] = GetMethod(SPECIAL_METHOD_NAMES[i]);
+    }
+}
+
+const Method* Class::GetMethod(std::string_view name) const {
+    auto it = method_table_.find(name);
+    return it != method_table_.end() ? it->second : nullptr;
+}
+
+const Method* Class::GetMethod(std::string_view name, size_t argument_count) const {
+    const Method* m = GetMethod(name);
+    return m && m->formal_params.size() == argument_count ? m : nullptr;
 }
 
 [[nodiscard]] const std::string& Class::GetName() const {
     return name_;
 }
 
+const std::vector<Method>& Class::GetMethods() const {
+    return methods_;
+}
+
+const Class* Class::GetParent() const {
+    return parent_;
+}
+
+const Shape& Class::GetRootShape() const {
+    return root_shape_;
+}
+
 void Class::Print(ostream& os, [[maybe_unused]] Context& context) {
     os << "Class "sv << name_;
 }
@@ -174,37 +387,24 @@ struct Le {
 
 template <typename Comp>
 bool CompareValueObjects(const ObjectHolder& lhs, const ObjectHolder& rhs, Comp comp) {
-    auto bool_l = lhs.TryAs<Bool>();
-    auto bool_r = rhs.TryAs<Bool>();
-    if (bool_l) {
-        if (bool_r) {
-            return comp(bool_l->GetValue(), bool_r->GetValue());
-        }
-        else {
-            throw std::runtime_error("Different types of compared objects"s);
-        }
-    }
-    auto num_l = lhs.TryAs<Number>();
-    auto num_r = rhs.TryAs<Number>();
-    if (num_l) {
-        if (num_r) {
-            return comp(num_l->GetValue(), num_r->GetValue());
-        }
-        else {
-            throw std::runtime_error("Different types of compared objects"s);
-        }
+    switch (KindPair(lhs.GetKind(), rhs.GetKind())) {
+    case KindPair(ObjectKind::BOOL, ObjectKind::BOOL):
+        return comp(lhs.As<Bool>().GetValue(), rhs.As<Bool>().GetValue());
+    case KindPair(ObjectKind::NUMBER, ObjectKind::NUMBER):
+        return comp(lhs.GetNumber(), rhs.GetNumber());
+    case KindPair(ObjectKind::STRING, ObjectKind::STRING):
+        return comp(lhs.As<String>().GetValue(), rhs.As<String>().GetValue());
+    default:
+        break;
     }
-    auto str_l = lhs.TryAs<String>();
-    auto str_r = rhs.TryAs<String>();
-    if (str_l) {
-        if (str_r) {
-            return comp(str_l->GetValue(), str_r->GetValue());
-        }
-        else {
-            throw std::runtime_error("Different types of compared objects"s);
-        }
+    switch (lhs.GetKind()) {
+    case ObjectKind::BOOL:
+    case ObjectKind::NUMBER:
+    case ObjectKind::STRING:
+        throw std::runtime_error("Different types of compared objects"s);
+    default:
+        throw std::runtime_error("Comparation error"s);
     }
-    throw std::runtime_error("Comparation error"s);
 }
 
 bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
@@ -214,9 +414,9 @@ bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
     }
     if (ClassInstance* ptr = lhs.TryAs<ClassInstance>();
         ptr != nullptr) {
-        if (ptr->HasMethod("__eq__"s, 1)) {
-            Bool* res = ptr->Call("__eq__"s, { rhs }, context).TryAs<Bool>();
-            if (res) {
+        if (const Method* m = ptr->GetClass().GetSpecialMethod(SpecialMethod::EQ, 1)) {
+            ObjectHolder result = ptr->Call(*m, { rhs }, context);
+            if (const Bool* res = result.TryAs<Bool>()) {
                 return res->GetValue();
             }
         }
@@ -231,9 +431,9 @@ bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
 
     if (ClassInstance* ptr = lhs.TryAs<ClassInstance>();
         ptr != nullptr) {
-        if (ptr->HasMethod("__lt__"s, 1)) {
-            Bool* res = ptr->Call("__lt__"s, { rhs }, context).TryAs<Bool>();
-            if (res) {
+        if (const Method* m = ptr->GetClass().GetSpecialMethod(SpecialMethod::LT, 1)) {
+            ObjectHolder result = ptr->Call(*m, { rhs }, context);
+            if (const Bool* res = result.TryAs<Bool>()) {
                 return res->GetValue();
             }
         }
@@ -244,20 +444,100 @@ bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
     throw std::runtime_error("Cannot compare objects for less"s);
 }
 
+// Если lhs - объект со специальным методом kind, записывает в result результат вызова
+// lhs.kind(rhs) и возвращает true. Если метод вернул не Bool, выбрасывает runtime_error
+bool CallComparisonMethod(const ObjectHolder& lhs, SpecialMethod kind, const ObjectHolder& rhs,
+    Context& context, bool& result) {
+    ClassInstance* ptr = lhs.TryAs<ClassInstance>();
+    if (!ptr) {
+        return false;
+    }
+    const Method* m = ptr->GetClass().GetSpecialMethod(kind, 1);
+    if (!m) {
+        return false;
+    }
+    if (const Bool* res = ptr->Call(*m, { rhs }, context).TryAs<Bool>()) {
+        result = res->GetValue();
+        return true;
+    }
+    throw std::runtime_error("Comparation error"s);
+}
+
 bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    bool result = false;
+    if (CallComparisonMethod(lhs, SpecialMethod::NE, rhs, context, result)) {
+        return result;
+    }
     return !Equal(lhs, rhs, context);
 }
 
 bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    bool result = false;
+    if (CallComparisonMethod(lhs, SpecialMethod::GT, rhs, context, result)) {
+        return result;
+    }
     return !Less(lhs, rhs, context) && !Equal(lhs, rhs, context);
 }
 
 bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    bool result = false;
+    if (CallComparisonMethod(lhs, SpecialMethod::LE, rhs, context, result)) {
+        return result;
+    }
     return Less(lhs, rhs, context) || Equal(lhs, rhs, context);
 }
 
 bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    bool result = false;
+    if (CallComparisonMethod(lhs, SpecialMethod::GE, rhs, context, result)) {
+        return result;
+    }
     return !Less(lhs, rhs, context);
 }
 
+ObjectHolder Add(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context) {
+    switch (KindPair(lhs.GetKind(), rhs.GetKind())) {
+    case KindPair(ObjectKind::NUMBER, ObjectKind::NUMBER):
+        return ObjectHolder::Own(Number(lhs.GetNumber() + rhs.GetNumber()));
+    case KindPair(ObjectKind::STRING, ObjectKind::STRING):
+        return ObjectHolder::Own(String(lhs.As<String>().GetValue() + rhs.As<String>().GetValue()));
+    default:
+        break;
+    }
+    if (lhs.GetKind() == ObjectKind::CLASS_INSTANCE) {
+        auto& instance = lhs.As<ClassInstance>();
+        if (const Method* m = instance.GetClass().GetSpecialMethod(SpecialMethod::ADD, 1)) {
+            return instance.Call(*m, { rhs }, context);
+        }
+    }
+    throw std::runtime_error("Failed to add, check arguments"s);
+}
+
+ObjectHolder Sub(const ObjectHolder& lhs, const ObjectHolder& rhs,
+    [[maybe_unused]] Context& context) {
+    if (lhs.GetKind() == ObjectKind::NUMBER && rhs.GetKind() == ObjectKind::NUMBER) {
+        return ObjectHolder::Own(Number(lhs.GetNumber() - rhs.GetNumber()));
+    }
+    throw std::runtime_error("Failed to sub, check arguments"s);
+}
+
+ObjectHolder Mult(const ObjectHolder& lhs, const ObjectHolder& rhs,
+    [[maybe_unused]] Context& context) {
+    if (lhs.GetKind() == ObjectKind::NUMBER && rhs.GetKind() == ObjectKind::NUMBER) {
+        return ObjectHolder::Own(Number(lhs.GetNumber() * rhs.GetNumber()));
+    }
+    throw std::runtime_error("Failed to mult, check arguments"s);
+}
+
+ObjectHolder Div(const ObjectHolder& lhs, const ObjectHolder& rhs,
+    [[maybe_unused]] Context& context) {
+    if (lhs.GetKind() == ObjectKind::NUMBER && rhs.GetKind() == ObjectKind::NUMBER) {
+        if (rhs.GetNumber() == 0) {
+            throw std::runtime_error("Failed to divide by 0, can't deal with eternity"s);
+        }
+        return ObjectHolder::Own(Number(lhs.GetNumber() / rhs.GetNumber()));
+    }
+    throw std::runtime_error("Failed to div, check arguments"s);
+}
+
 }  // namespace runtime
\ No newline at end of file
@@ -1,95 +1,532 @@
 ﻿#pragma once
 
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdint>
+#ifdef MYTHON_ATOMIC_REFCOUNT
+#include <atomic>
+#endif
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <type_traits>
 #include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace runtime {
 
+class ObjectHolder;
+
+// Слот переменной во фрейме вызова метода. Пустой слот соответствует переменной,
+// которой ещё не было присвоено значение
+using FrameSlot = std::optional<ObjectHolder>;
+
+/*
+ * Стек фреймов вызовов методов. Слоты выделяются блоками, которые остаются у стека и
+ * используются следующими вызовами, поэтому вызов метода не выделяет динамическую память
+ */
+class FrameStack {
+public:
+    // Положение вершины стека
+    struct Mark {
+        size_t block = 0;
+        size_t top = 0;
+    };
+
+    FrameStack() = default;
+    FrameStack(const FrameStack&) = delete;
+    FrameStack& operator=(const FrameStack&) = delete;
+    ~FrameStack();
+
+    // Размещает на вершине стека size пустых слотов и возвращает указатель на первый из них.
+    // В mark записывается положение вершины стека до размещения
+    FrameSlot* Push(size_t size, Mark& mark);
+
+    // Очищает слоты frame[0, size), размещённые последним вызовом Push,
+    // и возвращает вершину стека в положение mark
+    void Pop(FrameSlot* frame, size_t size, const Mark& mark);
+
+private:
+    // Минимальный размер блока слотов
+    static constexpr size_t BLOCK_SIZE = 1024;
+
+    struct Block {
+        std::unique_ptr<FrameSlot[]> slots;
+        size_t size = 0;
+    };
+
+    std::vector<Block> blocks_;
+    // Номер блока на вершине стека и количество занятых в нём слотов
+    size_t block_ = 0;
+    size_t top_ = 0;
+};
+
 // Контекст исполнения инструкций Mython
 class Context {
 public:
     // Возвращает поток вывода для команд print
     virtual std::ostream& GetOutputStream() = 0;
 
+    // Возвращает стек, в котором размещаются фреймы вызываемых методов
+    [[nodiscard]] FrameStack& GetFrameStack() {
+        return frame_stack_;
+    }
+
+    // Возвращает фрейм выполняемого метода либо nullptr, если переменные хранятся в Closure
+    [[nodiscard]] FrameSlot* GetFrame() const {
+        return frame_;
+    }
+
+    // Делает frame фреймом выполняемого метода и возвращает предыдущий фрейм
+    FrameSlot* SwapFrame(FrameSlot* frame) {
+        FrameSlot* previous = frame_;
+        frame_ = frame;
+        return previous;
+    }
+
 protected:
     ~Context() = default;
+
+private:
+    FrameStack frame_stack_;
+    FrameSlot* frame_ = nullptr;
+};
+
+// Делает frame фреймом выполняемого метода и восстанавливает предыдущий фрейм при разрушении
+class FrameScope {
+public:
+    FrameScope(Context& context, FrameSlot* frame)
+        : context_(context)
+        , previous_(context.SwapFrame(frame)) {
+    }
+
+    FrameScope(const FrameScope&) = delete;
+    FrameScope& operator=(const FrameScope&) = delete;
+
+    ~FrameScope() {
+        context_.SwapFrame(previous_);
+    }
+
+private:
+    Context& context_;
+    FrameSlot* previous_;
+};
+
+// Счётчик ссылок на объект. По умолчанию интерпретатор однопоточный и счётчик не атомарный,
+// атомарный счётчик включается макросом MYTHON_ATOMIC_REFCOUNT
+class RefCounter {
+public:
+    RefCounter() = default;
+    // Копия объекта - новый объект, на который пока никто не ссылается, поэтому
+    // значение счётчика не копируется
+    RefCounter(const RefCounter& /*other*/) noexcept {
+    }
+    RefCounter& operator=(const RefCounter& /*other*/) noexcept {
+        return *this;
+    }
+
+    void Increment() noexcept {
+        ++count_;
+    }
+
+    // Возвращает true, если ссылок на объект больше не осталось
+    [[nodiscard]] bool Decrement() noexcept {
+        return --count_ == 0;
+    }
+
+private:
+#ifdef MYTHON_ATOMIC_REFCOUNT
+    std::atomic<std::uint32_t> count_ = 0;
+#else
+    std::uint32_t count_ = 0;
+#endif
 };
 
+// Вид объекта Mython. Позволяет определить тип объекта без RTTI
+enum class ObjectKind : std::uint8_t {
+    NONE,
+    NUMBER,
+    STRING,
+    BOOL,
+    CLASS,
+    CLASS_INSTANCE,
+    OTHER,  // прочие наследники Object, их тип определяется через dynamic_cast
+};
+
+// Количество элементов ObjectKind
+inline constexpr unsigned OBJECT_KIND_COUNT = static_cast<unsigned>(ObjectKind::OTHER) + 1;
+
+// Возвращает номер пары видов (lhs, rhs) для диспетчеризации бинарных операций через switch
+constexpr unsigned KindPair(ObjectKind lhs, ObjectKind rhs) {
+    return static_cast<unsigned>(lhs) * OBJECT_KIND_COUNT + static_cast<unsigned>(rhs);
+}
+
 // Базовый класс для всех объектов языка Mython
+// Объект хранит счётчик владеющих им ObjectHolder и удаляется, когда счётчик становится равен 0
 class Object {
 public:
     virtual ~Object() = default;
     // выводит в os своё представление в виде строки
     virtual void Print(std::ostream& os, Context& context) = 0;
+
+    [[nodiscard]] ObjectKind GetKind() const {
+        return kind_;
+    }
+
+protected:
+    Object() = default;
+    explicit Object(ObjectKind kind)
+        : kind_(kind) {
+    }
+
+private:
+    friend class ObjectHolder;
+
+    RefCounter ref_count_;
+    ObjectKind kind_ = ObjectKind::OTHER;
 };
 
+// Вид объектов типа T. Для типов, не перечисленных в ObjectKind, равен ObjectKind::OTHER
+template <typename T>
+inline constexpr ObjectKind KIND_OF = ObjectKind::OTHER;
+
+// Объект-значение, хранящий значение типа T
+template <typename T>
+class ValueObject : public Object {
+public:
+    ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
+        : Object(ValueKind())
+        , value_(v) {
+    }
+
+    void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
+        os << value_;
+    }
+
+    [[nodiscard]] const T& GetValue() const {
+        return value_;
+    }
+
+private:
+    static constexpr ObjectKind ValueKind() {
+        if constexpr (std::is_same_v<T, int>) {
+            return ObjectKind::NUMBER;
+        }
+        else if constexpr (std::is_same_v<T, std::string>) {
+            return ObjectKind::STRING;
+        }
+        else if constexpr (std::is_same_v<T, bool>) {
+            return ObjectKind::BOOL;
+        }
+        else {
+            return ObjectKind::OTHER;
+        }
+    }
+
+    T value_;
+};
+
+// Строковое значение
+using String = ValueObject<std::string>;
+// Числовое значение
+using Number = ValueObject<int>;
+
+// Логическое значение
+class Bool : public ValueObject<bool> {
+public:
+    using ValueObject<bool>::ValueObject;
+
+    void Print(std::ostream& os, Context& context) override;
+};
+
+class Class;
+class ClassInstance;
+
+template <>
+inline constexpr ObjectKind KIND_OF<Number> = ObjectKind::NUMBER;
+template <>
+inline constexpr ObjectKind KIND_OF<String> = ObjectKind::STRING;
+template <>
+inline constexpr ObjectKind KIND_OF<Bool> = ObjectKind::BOOL;
+template <>
+inline constexpr ObjectKind KIND_OF<Class> = ObjectKind::CLASS;
+template <>
+inline constexpr ObjectKind KIND_OF<ClassInstance> = ObjectKind::CLASS_INSTANCE;
+
+// Диапазон чисел, для которых заранее созданы общие для всего интерпретатора объекты Number
+inline constexpr int SMALL_NUMBER_MIN = -5;
+inline constexpr int SMALL_NUMBER_MAX = 1024;
+
 // Специальный класс-обёртка, предназначенный для хранения объекта в Mython-программе
+// Числа хранятся внутри ObjectHolder как значение int и читаются методом GetNumber. Объект
+// Number для такого числа создаётся в куче только при обращении к неконстантному ObjectHolder
+// через Get, operator-> или As<Number>: константные методы ObjectHolder его не изменяют.
+// True, False и небольшие числа ссылаются на общие неуничтожаемые объекты,
+// остальные объекты хранятся в куче
 class ObjectHolder {
 public:
     // Создаёт пустое значение
-    ObjectHolder() = default;
+    ObjectHolder() noexcept
+        : kind_(Kind::NONE) {
+    }
+
+    ObjectHolder(const ObjectHolder& other) noexcept
+        : kind_(Kind::NONE) {
+        CopyFrom(other);
+    }
+
+    ObjectHolder(ObjectHolder&& other) noexcept
+        : kind_(Kind::NONE) {
+        MoveFrom(std::move(other));
+    }
+
+    ObjectHolder& operator=(const ObjectHolder& other) noexcept {
+        if (this != &other) {
+            Reset();
+            CopyFrom(other);
+        }
+        return *this;
+    }
+
+    ObjectHolder& operator=(ObjectHolder&& other) noexcept {
+        if (this != &other) {
+            Reset();
+            MoveFrom(std::move(other));
+        }
+        return *this;
+    }
+
+    ~ObjectHolder() {
+        Reset();
+    }
 
     // Возвращает ObjectHolder, владеющий объектом типа T
     // Тип T - конкретный класс-наследник Object.
-    // object копируется или перемещается в кучу
+    // Для Bool и чисел из диапазона [SMALL_NUMBER_MIN, SMALL_NUMBER_MAX] возвращает ссылку на
+    // общий объект, значения прочих Number хранятся внутри ObjectHolder, остальные объекты
+    // копируются или перемещаются в кучу
     template <typename T>
     [[nodiscard]] static ObjectHolder Own(T&& object) {
-        return ObjectHolder(std::make_shared<T>(std::forward<T>(object)));
+        using Type = std::decay_t<T>;
+        if constexpr (std::is_same_v<Type, Number> || std::is_same_v<Type, Bool>) {
+            return ObjectHolder(Type(std::forward<T>(object)));
+        }
+        else {
+            return ObjectHolder(new Type(std::forward<T>(object)));
+        }
     }
 
     // Создаёт ObjectHolder, не владеющий объектом (аналог слабой ссылки)
-    [[nodiscard]] static ObjectHolder Share(Object& object);
+    // Не выделяет память и не изменяет счётчик ссылок объекта
+    [[nodiscard]] static ObjectHolder Share(Object& object) noexcept;
     // Создаёт пустой ObjectHolder, соответствующий значению None
     [[nodiscard]] static ObjectHolder None();
+    // Возвращают ObjectHolder, ссылающийся на общий объект True или False
+    [[nodiscard]] static ObjectHolder True() noexcept;
+    [[nodiscard]] static ObjectHolder False() noexcept;
 
     // Возвращает ссылку на Object внутри ObjectHolder.
     // ObjectHolder должен быть непустым
     Object& operator*() const;
+    Object& operator*();
 
     Object* operator->() const;
+    Object* operator->();
+
+    // Возвращает указатель на хранящийся объект либо nullptr для значения None.
+    // Константный ObjectHolder не должен хранить число в виде int
+    [[nodiscard]] Object* Get() const {
+        switch (kind_) {
+        case Kind::NUMBER:
+            assert(!"ObjectHolder::Get() const for an unboxed number, use GetNumber");
+            return nullptr;
+        case Kind::OBJECT:
+        case Kind::BORROWED:
+            return object_;
+        default:
+            return nullptr;
+        }
+    }
+
+    // Для числа, хранящегося как int, сначала создаёт объект Number в куче, которым
+    // ObjectHolder и его последующие копии далее владеют. Указатель действителен,
+    // пока ObjectHolder существует и не изменяется
+    [[nodiscard]] Object* Get() {
+        if (kind_ == Kind::NUMBER) {
+            Box();
+        }
+        return std::as_const(*this).Get();
+    }
 
-    [[nodiscard]] Object* Get() const;
+    // Возвращает вид хранящегося объекта либо ObjectKind::NONE для значения None
+    [[nodiscard]] ObjectKind GetKind() const {
+        switch (kind_) {
+        case Kind::NUMBER:
+            return ObjectKind::NUMBER;
+        case Kind::OBJECT:
+        case Kind::BORROWED:
+            return object_->GetKind();
+        default:
+            return ObjectKind::NONE;
+        }
+    }
+
+    // Возвращает значение числа без создания объекта Number
+    // ObjectHolder должен хранить Number
+    [[nodiscard]] int GetNumber() const {
+        assert(GetKind() == ObjectKind::NUMBER);
+        return kind_ == Kind::NUMBER ? number_ : static_cast<const Number*>(object_)->GetValue();
+    }
 
     // Возвращает указатель на объект типа T либо nullptr, если внутри ObjectHolder не хранится
     // объект данного типа
+    // Для типов с известным видом (KIND_OF<T>) проверка выполняется без RTTI
     template <typename T>
     [[nodiscard]] T* TryAs() const {
-        return dynamic_cast<T*>(this->Get());
+        using Type = std::remove_cv_t<T>;
+        if constexpr (std::is_same_v<Type, Object>) {
+            return Get();
+        }
+        else if constexpr (KIND_OF<Type> != ObjectKind::OTHER) {
+            return GetKind() == KIND_OF<Type> ? &As<Type>() : nullptr;
+        }
+        else if constexpr (!std::is_base_of_v<Type, Number>) {
+            return kind_ == Kind::NUMBER ? nullptr : dynamic_cast<T*>(Get());
+        }
+        else {
+            return dynamic_cast<T*>(Get());
+        }
+    }
+
+    template <typename T>
+    [[nodiscard]] T* TryAs() {
+        if (kind_ == Kind::NUMBER) {
+            Box();
+        }
+        return std::as_const(*this).template TryAs<T>();
+    }
+
+    // Возвращает ссылку на объект типа T без проверки типа
+    // ObjectHolder должен хранить объект типа T
+    template <typename T>
+    [[nodiscard]] T& As() const {
+        assert(TypeMatches<T>());
+        return *static_cast<T*>(Get());
+    }
+
+    template <typename T>
+    [[nodiscard]] T& As() {
+        if (kind_ == Kind::NUMBER) {
+            Box();
+        }
+        return std::as_const(*this).template As<T>();
     }
 
     // Возвращает true, если ObjectHolder не пуст
-    explicit operator bool() const;
+    explicit operator bool() const {
+        return kind_ != Kind::NONE;
+    }
 
 private:
-    explicit ObjectHolder(std::shared_ptr<Object> data);
-    void AssertIsValid() const;
+    // Способ хранения значения внутри ObjectHolder
+    enum class Kind : std::uint8_t {
+        NONE,
+        NUMBER,
+        OBJECT,  // объект в куче, ObjectHolder участвует в подсчёте ссылок на него
+        BORROWED,  // объект, время жизни которого ObjectHolder не контролирует
+    };
 
-    std::shared_ptr<Object> data_;
-};
+    // Принимает во владение объект, созданный в куче
+    explicit ObjectHolder(Object* data) noexcept;
 
-// Объект-значение, хранящий значение типа T
-template <typename T>
-class ValueObject : public Object {
-public:
-    ValueObject(T v)  // NOLINT(google-explicit-constructor,hicpp-explicit-conversions)
-        : value_(v) {
+    template <typename T>
+    [[nodiscard]] bool TypeMatches() const {
+        if constexpr (KIND_OF<T> != ObjectKind::OTHER) {
+            return GetKind() == KIND_OF<T>;
+        }
+        else {
+            return kind_ != Kind::NUMBER && dynamic_cast<T*>(Get()) != nullptr;
+        }
     }
+    explicit ObjectHolder(Number value) noexcept;
+    explicit ObjectHolder(Bool value) noexcept;
+    // Создаёт ObjectHolder, ссылающийся на неуничтожаемый объект
+    [[nodiscard]] static ObjectHolder Immortal(const Object& object) noexcept;
+    void AssertIsValid() const;
+    // Переносит хранящееся значение int в объект Number в куче
+    void Box();
 
-    void Print(std::ostream& os, [[maybe_unused]] Context& context) override {
-        os << value_;
+    void CopyFrom(const ObjectHolder& other) noexcept;
+    void MoveFrom(ObjectHolder&& other) noexcept;
+    void Reset() noexcept;
+
+    static void AddRef(Object* object) noexcept {
+        object->ref_count_.Increment();
     }
 
-    [[nodiscard]] const T& GetValue() const {
-        return value_;
+    static void Release(Object* object) noexcept {
+        if (object->ref_count_.Decrement()) {
+            delete object;
+        }
     }
 
-private:
-    T value_;
+    Kind kind_;
+    union {
+        int number_;
+        Object* object_;
+    };
 };
 
+inline void ObjectHolder::CopyFrom(const ObjectHolder& other) noexcept {
+    switch (other.kind_) {
+    case Kind::NUMBER:
+        number_ = other.number_;
+        break;
+    case Kind::OBJECT:
+        object_ = other.object_;
+        AddRef(object_);
+        break;
+    case Kind::BORROWED:
+        object_ = other.object_;
+        break;
+    default:
+        break;
+    }
+    kind_ = other.kind_;
+}
+
+inline void ObjectHolder::MoveFrom(ObjectHolder&& other) noexcept {
+    switch (other.kind_) {
+    case Kind::NUMBER:
+        number_ = other.number_;
+        break;
+    case Kind::OBJECT:
+    case Kind::BORROWED:
+        // Ссылка переходит к новому владельцу, счётчик не меняется
+        object_ = other.object_;
+        break;
+    default:
+        break;
+    }
+    kind_ = other.kind_;
+    other.kind_ = Kind::NONE;
+}
+
+inline void ObjectHolder::Reset() noexcept {
+    switch (kind_) {
+    case Kind::OBJECT:
+        Release(object_);
+        break;
+    default:
+        break;
+    }
+    kind_ = Kind::NONE;
+}
+
 // Таблица символов, связывающая имя объекта с его значением
 using Closure = std::unordered_map<std::string, ObjectHolder>;
 
@@ -97,6 +534,48 @@ using Closure = std::unordered_map<std::string, ObjectHolder>;
 // Для отличных от нуля чисел, True и непустых строк возвращается true. В остальных случаях - false.
 bool IsTrue(const ObjectHolder& object);
 
+// Выводит значение object в поток os так же, как команда print. Для None выводит None,
+// числа выводятся без создания объекта Number
+void PrintValue(const ObjectHolder& object, std::ostream& os, Context& context);
+
+// Фрейм вызова метода на вершине стека FrameStack. Освобождается при разрушении объекта
+class StackFrame {
+public:
+    StackFrame(FrameStack& stack, size_t size)
+        : stack_(stack)
+        , size_(size)
+        , slots_(stack.Push(size, mark_)) {
+    }
+
+    StackFrame(const StackFrame&) = delete;
+    StackFrame& operator=(const StackFrame&) = delete;
+
+    ~StackFrame() {
+        stack_.Pop(slots_, size_, mark_);
+    }
+
+    [[nodiscard]] FrameSlot* Get() const {
+        return slots_;
+    }
+
+    FrameSlot& operator[](size_t index) {
+        assert(index < size_);
+        return slots_[index];
+    }
+
+private:
+    FrameStack& stack_;
+    size_t size_;
+    FrameStack::Mark mark_;
+    FrameSlot* slots_;
+};
+
+// Способ, которым завершилось выполнение инструкции
+enum class Completion : std::uint8_t {
+    NORMAL,  // выполнение продолжается со следующей инструкции
+    RETURN,  // выполнена инструкция return, текущий метод должен завершиться
+};
+
 // Интерфейс для выполнения действий над объектами Mython
 class Executable {
 public:
@@ -104,19 +583,42 @@ public:
     // Выполняет действие над объектами внутри closure, используя context
     // Возвращает результирующее значение либо None
     virtual ObjectHolder Execute(Closure& closure, Context& context) = 0;
-};
 
-// Строковое значение
-using String = ValueObject<std::string>;
-// Числовое значение
-using Number = ValueObject<int>;
+    /*
+     * Выполняет действие как инструкцию тела метода. Если внутри была выполнена
+     * инструкция return, возвращает Completion::RETURN и записывает её результат в return_value.
+     * По умолчанию вызывает Execute и отбрасывает результат. Переопределяется инструкциями,
+     * которые могут содержать return
+     */
+    virtual Completion ExecuteStatement(Closure& closure, Context& context,
+        [[maybe_unused]] ObjectHolder& return_value) {
+        Execute(closure, context);
+        return Completion::NORMAL;
+    }
 
-// Логическое значение
-class Bool : public ValueObject<bool> {
-public:
-    using ValueObject<bool>::ValueObject;
+    /*
+     * Вычисляет значение как условие: возвращает то же, что IsTrue(Execute(closure, context)).
+     * Переопределяется логическими операциями и сравнениями, которые получают результат
+     * без создания объекта Bool
+     */
+    virtual bool ExecuteAsBool(Closure& closure, Context& context) {
+        return IsTrue(Execute(closure, context));
+    }
 
-    void Print(std::ostream& os, Context& context) override;
+    /*
+     * Вычисляет значение. Если это число, записывает его в number и возвращает true,
+     * иначе записывает значение в value и возвращает false. Переопределяется арифметическими
+     * операциями, которые вычисляют вложенные выражения над числами без создания объектов Number
+     */
+    virtual bool ExecuteAsInt(Closure& closure, Context& context, int& number,
+        ObjectHolder& value) {
+        value = Execute(closure, context);
+        if (value.GetKind() == ObjectKind::NUMBER) {
+            number = value.GetNumber();
+            return true;
+        }
+        return false;
+    }
 };
 
 // Метод класса
@@ -127,8 +629,60 @@ struct Method {
     std::vector<std::string> formal_params;
     // Тело метода
     std::unique_ptr<Executable> body;
+    // Количество слотов во фрейме вызова метода: self, параметры и локальные переменные.
+    // 0 означает, что слоты переменным не назначены и они хранятся в Closure
+    size_t frame_size = 0;
 };
 
+/*
+ * Форма (скрытый класс) экземпляра класса - упорядоченный список имён его полей.
+ * Экземпляры одного класса, в которые поля добавлялись в одинаковом порядке, имеют общую форму,
+ * а значения их полей хранятся в слотах с одинаковыми номерами.
+ * Формы образуют дерево: добавление поля переводит экземпляр в дочернюю форму
+ */
+class Shape {
+public:
+    // Номер слота, возвращаемый для отсутствующего поля
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    Shape() = default;
+    Shape(const Shape&) = delete;
+    Shape& operator=(const Shape&) = delete;
+    Shape(Shape&&) = default;
+    Shape& operator=(Shape&&) = default;
+
+    // Возвращает номер слота поля name либо NO_SLOT, если такого поля в форме нет
+    [[nodiscard]] size_t FindSlot(const std::string& name) const;
+
+    // Возвращает форму, получающуюся из текущей добавлением поля name.
+    // Переходы запоминаются, поэтому повторное добавление того же поля возвращает ту же форму
+    [[nodiscard]] Shape* AddField(const std::string& name) const;
+
+    // Возвращает имена полей в порядке номеров их слотов
+    [[nodiscard]] const std::vector<std::string>& GetFieldNames() const;
+
+private:
+    std::vector<std::string> names_;
+    std::unordered_map<std::string, size_t> slots_;
+    mutable std::unordered_map<std::string, std::unique_ptr<Shape>> transitions_;
+};
+
+// Специальные методы, через которые операции Mython работают с экземплярами классов
+enum class SpecialMethod : std::uint8_t {
+    INIT,  // __init__
+    STR,   // __str__
+    EQ,    // __eq__
+    LT,    // __lt__
+    ADD,   // __add__
+    GT,    // __gt__
+    LE,    // __le__
+    GE,    // __ge__
+    NE,    // __ne__
+};
+
+// Количество элементов SpecialMethod
+inline constexpr size_t SPECIAL_METHOD_COUNT = static_cast<size_t>(SpecialMethod::NE) + 1;
+
 // Класс
 class Class : public Object {
 public:
@@ -137,11 +691,32 @@ public:
     explicit Class(std::string name, std::vector<Method> methods, const Class* parent);
 
     // Возвращает указатель на метод name или nullptr, если метод с таким именем отсутствует
-    [[nodiscard]] const Method* GetMethod(const std::string& name) const;
+    // Поиск выполняется за O(1) по таблице, содержащей в том числе унаследованные методы
+    [[nodiscard]] const Method* GetMethod(std::string_view name) const;
+
+    // Возвращает указатель на метод name, принимающий argument_count параметров,
+    // или nullptr, если такого метода нет
+    [[nodiscard]] const Method* GetMethod(std::string_view name, size_t argument_count) const;
+
+    // Возвращает указатель на специальный метод kind, принимающий argument_count параметров,
+    // или nullptr, если такого метода нет. Специальные методы находятся при создании класса
+    [[nodiscard]] const Method* GetSpecialMethod(SpecialMethod kind, size_t argument_count) const {
+        const Method* m = special_methods_[static_cast<size_t>(kind)];
+        return m && m->formal_params.size() == argument_count ? m : nullptr;
+    }
 
     // Возвращает имя класса
     [[nodiscard]] const std::string& GetName() const;
 
+    // Возвращает собственные методы класса, без унаследованных
+    [[nodiscard]] const std::vector<Method>& GetMethods() const;
+
+    // Возвращает родительский класс либо nullptr для базового класса
+    [[nodiscard]] const Class* GetParent() const;
+
+    // Возвращает форму только что созданного экземпляра класса (без полей)
+    [[nodiscard]] const Shape& GetRootShape() const;
+
     // Выводит в os строку "Class <имя класса>", например "Class cat"
     void Print(std::ostream& os, Context& context) override;
 
@@ -149,6 +724,11 @@ private:
     std::string name_;
     std::vector<Method> methods_;
     const Class* parent_ = nullptr;
+    // Методы класса и его предков по имени. Ключи ссылаются на имена в methods_ классов
+    std::unordered_map<std::string_view, const Method*> method_table_;
+    // Специальные методы класса в порядке элементов SpecialMethod
+    std::array<const Method*, SPECIAL_METHOD_COUNT> special_methods_ = {};
+    Shape root_shape_;
 };
 
 // Экземпляр класса
@@ -171,17 +751,66 @@ public:
     ObjectHolder Call(const std::string& method, const std::vector<ObjectHolder>& actual_args,
         Context& context);
 
+    // Вызывает у объекта найденный заранее метод method класса объекта (или его предка).
+    // Количество actual_args должно совпадать с количеством параметров метода
+    ObjectHolder Call(const Method& method, const std::vector<ObjectHolder>& actual_args,
+        Context& context);
+
+    /*
+     * Вызывает у объекта метод method, значения параметров которого уже записаны в слоты
+     * frame[1..n] фрейма, размещённого в context.GetFrameStack(). Фрейм должен содержать
+     * не меньше GetFrameSize(method) слотов. В слот 0 записывается ссылка на объект
+     */
+    ObjectHolder CallInFrame(const Method& method, FrameSlot* frame, Context& context);
+
+    // Возвращает количество слотов фрейма, необходимое для вызова метода method
+    [[nodiscard]] static size_t GetFrameSize(const Method& method) {
+        return std::max(method.frame_size, method.formal_params.size() + 1);
+    }
+
+    // Возвращает класс объекта
+    [[nodiscard]] const Class& GetClass() const;
+
     // Возвращает true, если объект имеет метод method, принимающий argument_count параметров
     [[nodiscard]] bool HasMethod(const std::string& method, size_t argument_count) const;
 
-    // Возвращает ссылку на Closure, содержащий поля объекта
+    // Возвращает указатель на значение поля name либо nullptr, если такого поля нет
+    [[nodiscard]] ObjectHolder* FindField(const std::string& name);
+    [[nodiscard]] const ObjectHolder* FindField(const std::string& name) const;
+
+    // Присваивает полю name значение value, добавляя поле при необходимости.
+    // Возвращает ссылку на значение поля
+    ObjectHolder& SetField(const std::string& name, ObjectHolder value);
+
+    // Возвращает форму объекта либо nullptr, если поля объекта хранятся в Closure
+    [[nodiscard]] const Shape* GetShape() const;
+
+    // Возвращает значение поля, хранящегося в слоте slot формы GetShape().
+    // Вызывать только для объекта, у которого GetShape() != nullptr
+    [[nodiscard]] ObjectHolder& GetSlot(size_t slot) {
+        assert(!fields_ && slot < slots_.size());
+        return slots_[slot];
+    }
+
+    /*
+     * Возвращает ссылку на Closure, содержащий поля объекта.
+     * Это медленный путь: при первом вызове поля объекта переносятся из слотов в Closure,
+     * и в дальнейшем объект хранит поля только в нём
+     */
     [[nodiscard]] Closure& Fields();
     // Возвращает константную ссылку на Closure, содержащую поля объекта
     [[nodiscard]] const Closure& Fields() const;
 
 private:
+    // Переносит поля из слотов в fields_ (если это ещё не сделано) и возвращает fields_
+    Closure& ToDictionary() const;
+
     const Class& cls_;
-    Closure closure_;
+    // Форма объекта и значения полей в слотах, соответствующих форме
+    const Shape* shape_;
+    mutable std::vector<ObjectHolder> slots_;
+    // Поля объекта после перехода на медленный путь (вызова Fields())
+    mutable std::unique_ptr<Closure> fields_;
 };
 
 /*
@@ -203,15 +832,34 @@ bool Equal(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
  * Параметр context задаёт контекст для выполнения метода __lt__
  */
 bool Less(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-// Возвращает значение, противоположное Equal(lhs, rhs, context)
+/*
+ * Если lhs - объект с методом __ne__, __gt__, __le__ либо __ge__ соответственно, функции
+ * возвращают результат вызова этого метода, приведённый к типу bool. Иначе результат
+ * вычисляется функциями Equal и Less:
+ *  NotEqual - значение, противоположное Equal(lhs, rhs, context);
+ *  Greater - значение lhs>rhs, используя функции Equal и Less;
+ *  LessOrEqual - значение lhs<=rhs, используя функции Equal и Less;
+ *  GreaterOrEqual - значение, противоположное Less(lhs, rhs, context).
+ */
 bool NotEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-// Возвращает значение lhs>rhs, используя функции Equal и Less
 bool Greater(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-// Возвращает значение lhs<=rhs, используя функции Equal и Less
 bool LessOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
-// Возвращает значение, противоположное Less(lhs, rhs, context)
 bool GreaterOrEqual(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
 
+/*
+ * Арифметические операции над значениями lhs и rhs. Поддерживаются:
+ *  число + число, строка + строка,
+ *  объект + значение, если у объекта есть метод __add__(rhs);
+ *  число - число, число * число, число / число.
+ * В остальных случаях, а также при делении на 0 функции выбрасывают исключение runtime_error.
+ *
+ * Параметр context задаёт контекст для выполнения метода __add__
+ */
+ObjectHolder Add(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+ObjectHolder Sub(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+ObjectHolder Mult(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+ObjectHolder Div(const ObjectHolder& lhs, const ObjectHolder& rhs, Context& context);
+
 // Контекст-заглушка, применяется в тестах.
 // В этом контексте весь вывод перенаправляется в строковый поток вывода output
 struct DummyContext : Context {
@@ -19,7 +19,8 @@ public:
     }
 
     Logger(const Logger& rhs)
-        : id_(rhs.id_)  //
+        : Object(rhs)
+        , id_(rhs.id_)  //
     {
         ++instance_count;
     }
@@ -199,6 +200,22 @@ void TestNonowning() {
     ASSERT_EQUAL(context.output.str(), "784"sv);
 }
 
+void TestBorrowedDoesNotOwn() {
+    ASSERT_EQUAL(Logger::instance_count, 0);
+    {
+        auto owner = ObjectHolder::Own(Logger(11));
+        auto borrowed = ObjectHolder::Share(*owner);
+        ObjectHolder copy = borrowed;
+        ASSERT(copy.Get() == owner.Get());
+        ASSERT_EQUAL(copy.TryAs<Logger>()->GetId(), 11);
+
+        owner = ObjectHolder::None();
+        // Невладеющие ссылки не продлевают жизнь объекта
+        ASSERT_EQUAL(Logger::instance_count, 0);
+    }
+    ASSERT_EQUAL(Logger::instance_count, 0);
+}
+
 void TestOwning() {
     ASSERT_EQUAL(Logger::instance_count, 0);
     {
@@ -218,6 +235,30 @@ void TestOwning() {
     ASSERT_EQUAL(context.output.str(), "312"sv);
 }
 
+void TestSharedOwnership() {
+    ASSERT_EQUAL(Logger::instance_count, 0);
+    {
+        auto one = ObjectHolder::Own(Logger(5));
+        ObjectHolder two;
+        {
+            ObjectHolder copy = one;
+            two = copy;
+            ASSERT(copy.Get() == one.Get());
+            ASSERT_EQUAL(Logger::instance_count, 1);
+        }
+        one = ObjectHolder::None();
+        ASSERT_EQUAL(Logger::instance_count, 1);
+
+        // Копия объекта, которым владеет ObjectHolder, - независимый объект
+        auto three = ObjectHolder::Own(Logger(*two.TryAs<Logger>()));
+        ASSERT_EQUAL(Logger::instance_count, 2);
+        two = three;
+        ASSERT_EQUAL(Logger::instance_count, 1);
+        ASSERT_EQUAL(three.TryAs<Logger>()->GetId(), 5);
+    }
+    ASSERT_EQUAL(Logger::instance_count, 0);
+}
+
 void TestMove() {
     {
         ASSERT_EQUAL(Logger::instance_count, 0);
@@ -248,6 +289,110 @@ void TestNullptr() {
     ASSERT(!oh.Get());
 }
 
+void TestImmediateValues() {
+    // Число хранится как int рядом с признаком вида значения
+    ASSERT_EQUAL(sizeof(ObjectHolder), 2 * sizeof(void*));
+
+    auto num = ObjectHolder::Own(Number{100500});
+    ASSERT(num);
+    ASSERT(num.GetKind() == ObjectKind::NUMBER);
+    ASSERT_EQUAL(num.GetNumber(), 100500);
+    ObjectHolder unboxed_copy = num;
+    ASSERT(num.TryAs<Number>() != nullptr && num.TryAs<Number>()->GetValue() == 100500);
+    ASSERT(num.TryAs<Bool>() == nullptr);
+    ASSERT(num.TryAs<String>() == nullptr);
+    ASSERT(num.Get() == num.TryAs<Number>());
+    ASSERT_EQUAL(num.GetNumber(), 100500);
+    // Объект Number создаётся при первом обращении и далее общий для копий
+    ASSERT(unboxed_copy.Get() != num.Get());
+    ObjectHolder boxed_copy = num;
+    ASSERT(boxed_copy.Get() == num.Get());
+    ASSERT_EQUAL(boxed_copy.GetNumber(), 100500);
+
+    ObjectHolder copy = num;
+    ASSERT(copy.TryAs<Number>() != nullptr && copy.TryAs<Number>()->GetValue() == 100500);
+    ObjectHolder moved = std::move(num);
+    ASSERT(!num);  // NOLINT
+    ASSERT(moved.TryAs<Number>() != nullptr && moved.TryAs<Number>()->GetValue() == 100500);
+
+    auto flag = ObjectHolder::Own(Bool{true});
+    ASSERT(flag.TryAs<Bool>() != nullptr && flag.TryAs<Bool>()->GetValue());
+    ASSERT(flag.TryAs<Number>() == nullptr);
+    flag = copy;
+    ASSERT(flag.TryAs<Bool>() == nullptr);
+    ASSERT(flag.TryAs<Number>() != nullptr && flag.TryAs<Number>()->GetValue() == 100500);
+
+    DummyContext context;
+    flag->Print(context.output, context);
+    ASSERT_EQUAL(context.output.str(), "100500"sv);
+
+    // Вывод числа через константный ObjectHolder не создаёт объект Number:
+    // копии, сделанные после вывода, не ссылаются на общий объект
+    const ObjectHolder printed = ObjectHolder::Own(Number{200300});
+    ostringstream printed_output;
+    PrintValue(printed, printed_output, context);
+    ASSERT_EQUAL(printed_output.str(), "200300"s);
+    ObjectHolder first_copy = printed;
+    ObjectHolder second_copy = printed;
+    ASSERT(first_copy.Get() != second_copy.Get());
+
+    Number shared_num(7);
+    auto shared = ObjectHolder::Share(shared_num);
+    ASSERT(shared.TryAs<Number>() == &shared_num);
+}
+
+void TestCanonicalValues() {
+    ASSERT(ObjectHolder::True().Get() == ObjectHolder::Own(Bool{true}).Get());
+    ASSERT(ObjectHolder::False().Get() == ObjectHolder::Own(Bool{false}).Get());
+    ASSERT(ObjectHolder::True().Get() != ObjectHolder::False().Get());
+    ASSERT(ObjectHolder::True().TryAs<Bool>()->GetValue());
+    ASSERT(!ObjectHolder::False().TryAs<Bool>()->GetValue());
+
+    for (int n : {SMALL_NUMBER_MIN, 0, 7, SMALL_NUMBER_MAX}) {
+        auto one = ObjectHolder::Own(Number{n});
+        auto two = ObjectHolder::Own(Number{n});
+        ASSERT(one.Get() == two.Get());
+        ASSERT_EQUAL(one.TryAs<Number>()->GetValue(), n);
+    }
+    for (int n : {SMALL_NUMBER_MIN - 1, SMALL_NUMBER_MAX + 1, 1'000'000}) {
+        auto one = ObjectHolder::Own(Number{n});
+        auto two = ObjectHolder::Own(Number{n});
+        ASSERT(one.Get() != two.Get());
+        ASSERT_EQUAL(one.TryAs<Number>()->GetValue(), n);
+        ASSERT_EQUAL(two.TryAs<Number>()->GetValue(), n);
+    }
+}
+
+void TestObjectKinds() {
+    ASSERT(ObjectHolder::None().GetKind() == ObjectKind::NONE);
+    ASSERT(ObjectHolder::Own(Number{1}).GetKind() == ObjectKind::NUMBER);
+    ASSERT(ObjectHolder::Own(Bool{false}).GetKind() == ObjectKind::BOOL);
+    ASSERT(ObjectHolder::Own(String{"1"s}).GetKind() == ObjectKind::STRING);
+
+    Class cls{"Test"s, {}, nullptr};
+    auto cls_holder = ObjectHolder::Share(cls);
+    ASSERT(cls_holder.GetKind() == ObjectKind::CLASS);
+    ASSERT(cls_holder.TryAs<Class>() == &cls);
+    ASSERT(cls_holder.TryAs<ClassInstance>() == nullptr);
+
+    auto instance = ObjectHolder::Own(ClassInstance{cls});
+    ASSERT(instance.GetKind() == ObjectKind::CLASS_INSTANCE);
+    ASSERT(instance.TryAs<ClassInstance>() == &instance.As<ClassInstance>());
+    ASSERT(instance.TryAs<Class>() == nullptr);
+    ASSERT(instance.TryAs<Object>() == instance.Get());
+
+    // Для прочих наследников Object тип определяется через dynamic_cast
+    Logger logger(1);
+    auto other = ObjectHolder::Share(logger);
+    ASSERT(other.GetKind() == ObjectKind::OTHER);
+    ASSERT(other.TryAs<Logger>() == &logger);
+    ASSERT(other.TryAs<String>() == nullptr);
+    ASSERT(instance.TryAs<Logger>() == nullptr);
+
+    ASSERT(KindPair(ObjectKind::NUMBER, ObjectKind::STRING)
+           != KindPair(ObjectKind::STRING, ObjectKind::NUMBER));
+}
+
 void TestIsTrue() {
     {
         ASSERT(!IsTrue(ObjectHolder::Own(Bool{false})));
@@ -472,6 +617,44 @@ void TestComparison() {
         lt_result = ObjectHolder::Own(Bool{true});
         test_greater(ObjectHolder::Share(lhs), ObjectHolder::Share(rhs), false);
     }
+
+    // Class instances with __gt__, __le__, __ge__ and __ne__
+    {
+        vector<string> calls;
+        auto make_body = [&calls](string name, bool result) {
+            return std::make_unique<TestMethodBody>(
+                [&calls, name = std::move(name), result](Closure&, Context&) {
+                    calls.push_back(name);
+                    return ObjectHolder::Own(Bool{result});
+                });
+        };
+        std::vector<Method> base_methods;
+        base_methods.push_back({"__eq__"s, {"rhs"s}, make_body("__eq__"s, false)});
+        base_methods.push_back({"__lt__"s, {"rhs"s}, make_body("__lt__"s, false)});
+        base_methods.push_back({"__gt__"s, {"rhs"s}, make_body("__gt__"s, true)});
+        base_methods.push_back({"__le__"s, {"rhs"s}, make_body("__le__"s, true)});
+        Class base{"Base"s, std::move(base_methods), nullptr};
+        std::vector<Method> derived_methods;
+        derived_methods.push_back({"__ge__"s, {"rhs"s}, make_body("__ge__"s, true)});
+        derived_methods.push_back({"__ne__"s, {"rhs"s}, make_body("__ne__"s, false)});
+        Class derived{"Derived"s, std::move(derived_methods), &base};
+        ClassInstance lhs{derived};
+        DummyContext ctx;
+
+        // Каждое сравнение вызывает ровно один метод, в том числе унаследованный
+        ASSERT(Greater(ObjectHolder::Share(lhs), ObjectHolder::None(), ctx));
+        ASSERT(LessOrEqual(ObjectHolder::Share(lhs), ObjectHolder::None(), ctx));
+        ASSERT(GreaterOrEqual(ObjectHolder::Share(lhs), ObjectHolder::None(), ctx));
+        ASSERT(!NotEqual(ObjectHolder::Share(lhs), ObjectHolder::None(), ctx));
+        ASSERT_EQUAL(calls, (vector{"__gt__"s, "__le__"s, "__ge__"s, "__ne__"s}));
+
+        // Без метода __ne__ используется __eq__
+        calls.clear();
+        ClassInstance base_instance{base};
+        ASSERT(NotEqual(ObjectHolder::Share(base_instance), ObjectHolder::None(), ctx));
+        ASSERT(GreaterOrEqual(ObjectHolder::Share(base_instance), ObjectHolder::None(), ctx));
+        ASSERT_EQUAL(calls, (vector{"__eq__"s, "__lt__"s}));
+    }
 }
 
 void TestClass() {
@@ -504,6 +687,92 @@ void TestClass() {
     ASSERT_EQUAL(out.str(), "Class Test"s);
 }
 
+void TestMethodTable() {
+    vector<Method> base_methods;
+    base_methods.push_back({"f"s, {}, make_unique<TestMethodBody>(nullptr)});
+    base_methods.push_back({"g"s, {"x"s}, make_unique<TestMethodBody>(nullptr)});
+    Class base{"Base"s, std::move(base_methods), nullptr};
+
+    vector<Method> middle_methods;
+    middle_methods.push_back({"g"s, {}, make_unique<TestMethodBody>(nullptr)});
+    Class middle{"Middle"s, std::move(middle_methods), &base};
+
+    Class derived{"Derived"s, {}, &middle};
+
+    // Таблица методов класса включает методы всех предков
+    ASSERT(derived.GetMethod("f"s) == base.GetMethod("f"s));
+    ASSERT(derived.GetMethod("g"s) == middle.GetMethod("g"s));
+    ASSERT(derived.GetMethod("h"s) == nullptr);
+
+    ASSERT(derived.GetMethod("g"s, 0) == middle.GetMethod("g"s));
+    ASSERT(derived.GetMethod("g"s, 1) == nullptr);
+    ASSERT(base.GetMethod("g"s, 1) != nullptr);
+    ASSERT(derived.GetMethod("f"s, 0) != nullptr);
+}
+
+void TestFrameStack() {
+    FrameStack stack;
+
+    FrameStack::Mark outer_mark;
+    FrameSlot* outer = stack.Push(3, outer_mark);
+    outer[1] = ObjectHolder::Own(Number{1});
+
+    {
+        // Фрейм, который не помещается в текущий блок, размещается в новом блоке,
+        // и слоты ранее размещённых фреймов не перемещаются
+        StackFrame big(stack, 5000);
+        big[4999] = ObjectHolder::Own(String{"big"s});
+        StackFrame inner(stack, 2);
+        ASSERT(!inner[0]);
+        ASSERT(!inner[1]);
+        ASSERT_EQUAL(outer[1]->TryAs<Number>()->GetValue(), 1);
+    }
+
+    // Освобождённые слоты очищаются и используются следующими фреймами
+    FrameStack::Mark next_mark;
+    FrameSlot* next = stack.Push(2, next_mark);
+    ASSERT_EQUAL(next, outer + 3);
+    ASSERT(!next[0]);
+    stack.Pop(next, 2, next_mark);
+
+    {
+        StackFrame big(stack, 5000);
+        ASSERT(!big[4999]);
+    }
+
+    stack.Pop(outer, 3, outer_mark);
+    FrameStack::Mark mark;
+    ASSERT_EQUAL(stack.Push(1, mark), outer);
+    stack.Pop(outer, 1, mark);
+}
+
+void TestSpecialMethods() {
+    vector<Method> base_methods;
+    base_methods.push_back({"__str__"s, {}, make_unique<TestMethodBody>(nullptr)});
+    base_methods.push_back({"__eq__"s, {"rhs"s}, make_unique<TestMethodBody>(nullptr)});
+    Class base{"Base"s, std::move(base_methods), nullptr};
+
+    vector<Method> derived_methods;
+    derived_methods.push_back({"__init__"s, {"x"s}, make_unique<TestMethodBody>(nullptr)});
+    derived_methods.push_back({"__str__"s, {}, make_unique<TestMethodBody>(nullptr)});
+    derived_methods.push_back({"__add__"s, {}, make_unique<TestMethodBody>(nullptr)});
+    Class derived{"Derived"s, std::move(derived_methods), &base};
+
+    // Слоты специальных методов учитывают наследование и переопределение
+    ASSERT(derived.GetSpecialMethod(SpecialMethod::STR, 0) == derived.GetMethod("__str__"s));
+    ASSERT(derived.GetSpecialMethod(SpecialMethod::EQ, 1) == base.GetMethod("__eq__"s));
+    ASSERT(derived.GetSpecialMethod(SpecialMethod::INIT, 1) == derived.GetMethod("__init__"s));
+    ASSERT(base.GetSpecialMethod(SpecialMethod::INIT, 0) == nullptr);
+    ASSERT(derived.GetSpecialMethod(SpecialMethod::LT, 1) == nullptr);
+
+    // Метод с неподходящим числом параметров слот не заполняет
+    ASSERT(derived.GetSpecialMethod(SpecialMethod::INIT, 0) == nullptr);
+    ASSERT(derived.GetSpecialMethod(SpecialMethod::ADD, 1) == nullptr);
+
+    ClassInstance instance{derived};
+    ASSERT_EQUAL(&instance.GetClass(), &derived);
+}
+
 void TestClassInstance() {
     vector<Method> methods;
 
@@ -529,6 +798,46 @@ void TestClassInstance() {
     ASSERT_THROWS(instance.Call("missing_method"s, {}, ctx), runtime_error);
 }
 
+void TestInstanceShapes() {
+    Class cls{"Point"s, {}, nullptr};
+    ClassInstance a{cls};
+    ClassInstance b{cls};
+    ClassInstance c{cls};
+    ASSERT(a.GetShape() == &cls.GetRootShape());
+
+    a.SetField("x"s, ObjectHolder::Own(Number{1}));
+    a.SetField("y"s, ObjectHolder::Own(Number{2}));
+    b.SetField("x"s, ObjectHolder::Own(Number{3}));
+    b.SetField("y"s, ObjectHolder::Own(Number{4}));
+    c.SetField("y"s, ObjectHolder::Own(Number{5}));
+    c.SetField("x"s, ObjectHolder::Own(Number{6}));
+
+    // Поля, добавленные в одинаковом порядке, дают одну и ту же форму
+    ASSERT(a.GetShape() == b.GetShape());
+    ASSERT(a.GetShape() != c.GetShape());
+    ASSERT_EQUAL(a.GetShape()->FindSlot("x"s), 0U);
+    ASSERT_EQUAL(c.GetShape()->FindSlot("x"s), 1U);
+    ASSERT_EQUAL(a.GetShape()->FindSlot("z"s), Shape::NO_SLOT);
+
+    // Повторное присваивание не меняет форму
+    const Shape* shape = b.GetShape();
+    b.SetField("x"s, ObjectHolder::Own(String{"x"s}));
+    ASSERT(b.GetShape() == shape);
+    ASSERT_EQUAL(b.FindField("x"s)->TryAs<String>()->GetValue(), "x"s);
+    ASSERT_EQUAL(b.FindField("y"s)->TryAs<Number>()->GetValue(), 4);
+    ASSERT(b.FindField("z"s) == nullptr);
+
+    // После обращения к Fields() поля хранятся в Closure
+    Closure& fields = a.Fields();
+    ASSERT(a.GetShape() == nullptr);
+    ASSERT_EQUAL(fields.size(), 2U);
+    ASSERT_EQUAL(fields.at("x"s).TryAs<Number>()->GetValue(), 1);
+    a.SetField("z"s, ObjectHolder::Own(Number{7}));
+    ASSERT_EQUAL(fields.at("z"s).TryAs<Number>()->GetValue(), 7);
+    fields["w"s] = ObjectHolder::Own(Number{8});
+    ASSERT_EQUAL(a.FindField("w"s)->TryAs<Number>()->GetValue(), 8);
+}
+
 }  // namespace
 
 void RunObjectsTests(TestRunner& tr) {
@@ -536,17 +845,26 @@ void RunObjectsTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestString);
     RUN_TEST(tr, runtime::TestBool);
     RUN_TEST(tr, runtime::TestMethodInvocation);
+    RUN_TEST(tr, runtime::TestObjectKinds);
     RUN_TEST(tr, runtime::TestIsTrue);
     RUN_TEST(tr, runtime::TestComparison);
     RUN_TEST(tr, runtime::TestClass);
+    RUN_TEST(tr, runtime::TestMethodTable);
+    RUN_TEST(tr, runtime::TestSpecialMethods);
+    RUN_TEST(tr, runtime::TestFrameStack);
     RUN_TEST(tr, runtime::TestClassInstance);
+    RUN_TEST(tr, runtime::TestInstanceShapes);
 }
 
 void RunObjectHolderTests(TestRunner& tr) {
     RUN_TEST(tr, runtime::TestNonowning);
     RUN_TEST(tr, runtime::TestOwning);
+    RUN_TEST(tr, runtime::TestBorrowedDoesNotOwn);
+    RUN_TEST(tr, runtime::TestSharedOwnership);
     RUN_TEST(tr, runtime::TestMove);
     RUN_TEST(tr, runtime::TestNullptr);
+    RUN_TEST(tr, runtime::TestImmediateValues);
+    RUN_TEST(tr, runtime::TestCanonicalValues);
 }
 
 }  // namespace runtime
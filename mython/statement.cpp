@@ -1,7 +1,12 @@
 ﻿#include "statement.h"
 
+#include "jit.h"
+
+#include <algorithm>
+#include <cassert>
 #include <iostream>
 #include <sstream>
+#include <utility>
 
 using namespace std;
 
@@ -12,21 +17,313 @@ using runtime::Context;
 using runtime::ObjectHolder;
 
 namespace {
-const string ADD_METHOD = "__add__"s;
-const string INIT_METHOD = "__init__"s;
+const string SELF_NAME = "self"s;
+
+using runtime::ObjectKind;
+
+// Возвращает true, если lhs и rhs - объекты вида kind
+bool BothOfKind(const ObjectHolder& lhs, const ObjectHolder& rhs, ObjectKind kind) {
+    return lhs.GetKind() == kind && rhs.GetKind() == kind;
+}
+
+// Возвращает значения чисел lhs и rhs
+std::pair<int, int> NumberValues(const ObjectHolder& lhs, const ObjectHolder& rhs) {
+    return { lhs.GetNumber(), rhs.GetNumber() };
+}
+
+// Значение аргумента операции, вычисленное методом ExecuteAsInt:
+// число хранится без создания объекта Number
+struct Operand {
+    Operand(Statement& node, Closure& closure, Context& context)
+        : is_number(node.ExecuteAsInt(closure, context, number, value)) {
+    }
+
+    // Возвращает значение аргумента в виде объекта
+    [[nodiscard]] ObjectHolder Box() const {
+        return is_number ? ObjectHolder::Own(runtime::Number(number)) : value;
+    }
+
+    int number = 0;
+    ObjectHolder value;
+    bool is_number;
+};
+
+// Записывает результат операции в number, если это число, иначе в value.
+// Возвращает true, если результат - число
+bool StoreResult(ObjectHolder result, int& number, ObjectHolder& value) {
+    if (result.GetKind() == ObjectKind::NUMBER) {
+        number = result.GetNumber();
+        return true;
+    }
+    value = std::move(result);
+    return false;
+}
+
+// Вычисляет node методом ExecuteAsInt и возвращает значение в виде объекта
+ObjectHolder ExecuteBoxed(Statement& node, Closure& closure, Context& context) {
+    int number = 0;
+    ObjectHolder value;
+    if (node.ExecuteAsInt(closure, context, number, value)) {
+        return ObjectHolder::Own(runtime::Number(number));
+    }
+    return value;
+}
+
+// Возвращает true, если node - константа
+bool IsConstant(const Statement& node) {
+    return dynamic_cast<const NumericConst*>(&node) || dynamic_cast<const StringConst*>(&node)
+        || dynamic_cast<const BoolConst*>(&node) || dynamic_cast<const None*>(&node);
+}
+
+// Возвращает true, если значение node - всегда число, если вычисление не завершилось ошибкой
+bool IsNumeric(const Statement& node) {
+    return dynamic_cast<const NumericConst*>(&node) || dynamic_cast<const Sub*>(&node)
+        || dynamic_cast<const Mult*>(&node) || dynamic_cast<const Div*>(&node);
+}
+
+// Возвращает true, если значение node - всегда True либо False
+bool IsBoolean(const Statement& node) {
+    return dynamic_cast<const BoolConst*>(&node) || dynamic_cast<const Comparison*>(&node)
+        || dynamic_cast<const Not*>(&node) || dynamic_cast<const And*>(&node)
+        || dynamic_cast<const Or*>(&node);
+}
+
+// Возвращает константу со значением value либо nullptr, если у value нет записи в виде константы
+std::unique_ptr<Statement> MakeConstant(const ObjectHolder& value) {
+    switch (value.GetKind()) {
+    case ObjectKind::NONE:
+        return std::make_unique<None>();
+    case ObjectKind::NUMBER:
+        return std::make_unique<NumericConst>(value.GetNumber());
+    case ObjectKind::STRING:
+        return std::make_unique<StringConst>(value.As<runtime::String>().GetValue());
+    case ObjectKind::BOOL:
+        return std::make_unique<BoolConst>(value.As<runtime::Bool>().GetValue());
+    default:
+        return nullptr;
+    }
+}
+
+// Вычисляет node, аргументы которого - константы. Переменные и вывод node не использует
+ObjectHolder EvaluateConstant(Statement& node) {
+    Closure closure;
+    runtime::DummyContext context;
+    return node.Execute(closure, context);
+}
+
+// Вычисляет node, аргументы которого - константы, и возвращает константу с его значением.
+// Если вычисление завершилось ошибкой, возвращает nullptr: ошибка произойдёт при выполнении
+std::unique_ptr<Statement> Precompute(Statement& node) {
+    try {
+        return MakeConstant(EvaluateConstant(node));
+    } catch (const std::runtime_error&) {
+        return nullptr;
+    }
+}
+
+// Упрощает условие node. В условии важна только истинность значения, поэтому
+// not not x заменяется на x, даже если значение x - не логическое
+void FoldCondition(std::unique_ptr<Statement>& node) {
+    FoldNode(node);
+    while (auto* outer = dynamic_cast<Not*>(node.get())) {
+        if (!dynamic_cast<const Not*>(&outer->GetArgument())) {
+            break;
+        }
+        std::unique_ptr<Statement> inner = outer->ReleaseArgument();
+        node = static_cast<Not&>(*inner).ReleaseArgument();
+    }
+}
 }  // namespace
 
+MethodScope::MethodScope(const std::vector<std::string>& formal_params) {
+    DeclareSlot(SELF_NAME);
+    for (size_t i = 0; i < formal_params.size(); ++i) {
+        // Параметр с именем self заменяет self, как и при передаче параметров через Closure
+        slots_[formal_params[i]] = i + 1;
+    }
+    frame_size_ = formal_params.size() + 1;
+}
+
+size_t MethodScope::FindSlot(const std::string& name) const {
+    auto it = slots_.find(name);
+    return it != slots_.end() ? it->second : NO_SLOT;
+}
+
+size_t MethodScope::DeclareSlot(const std::string& name) {
+    auto [it, inserted] = slots_.emplace(name, frame_size_);
+    if (inserted) {
+        ++frame_size_;
+    }
+    return it->second;
+}
+
+void FieldChains::Read(VariableValue& variable) {
+    if (variable.GetSlot() == MethodScope::NO_SLOT) {
+        return;
+    }
+    std::vector<std::string> field_names = variable.GetFieldPath().GetFieldNames();
+    if (field_names.size() < MIN_LENGTH) {
+        return;
+    }
+    for (Chain& chain : chains_) {
+        if (chain.root_slot == variable.GetSlot() && chain.field_names == field_names) {
+            if (chain.shared_slot == MethodScope::NO_SLOT) {
+                chain.shared_slot = frame_size_++;
+                chain.first_read->StoreShared(chain.shared_slot);
+            }
+            variable.LoadShared(chain.shared_slot);
+            return;
+        }
+    }
+    chains_.push_back({ variable.GetSlot(), std::move(field_names), &variable });
+}
+
+void FieldChains::AssignVariable(size_t slot) {
+    chains_.erase(std::remove_if(chains_.begin(), chains_.end(), [slot](const Chain& chain) {
+        return chain.root_slot == slot;
+    }), chains_.end());
+}
+
+void FieldChains::AssignField(const std::string& field_name) {
+    // Объект, поле которого изменилось, может входить в любую цепочку с полем того же имени
+    chains_.erase(std::remove_if(chains_.begin(), chains_.end(), [&field_name](const Chain& chain) {
+        return std::find(chain.field_names.begin(), chain.field_names.end(), field_name)
+            != chain.field_names.end();
+    }), chains_.end());
+}
+
+void FoldNode(std::unique_ptr<Statement>& node) {
+    if (!node) {
+        return;
+    }
+    if (auto folded = node->Fold()) {
+        node = std::move(folded);
+    }
+}
+
+void FuseNode(std::unique_ptr<Statement>& node) {
+    if (!node) {
+        return;
+    }
+    if (auto fused = node->Fuse()) {
+        node = std::move(fused);
+    }
+}
+
 ObjectHolder Assignment::Execute(Closure& closure, Context& context) {
+    if (slot_ != MethodScope::NO_SLOT) {
+        runtime::FrameSlot& variable = context.GetFrame()[slot_];
+        variable = rv_.get()->Execute(closure, context);
+        return *variable;
+    }
     closure[var_] = rv_.get()->Execute(closure, context);
     return closure.at(var_);
 }
 
+void Assignment::ResolveNames(MethodScope& scope) {
+    // Правая часть вычисляется до того, как переменная получит значение
+    rv_->ResolveNames(scope);
+    slot_ = scope.DeclareSlot(var_);
+}
+
+std::unique_ptr<Statement> Assignment::Fold() {
+    FoldNode(rv_);
+    return nullptr;
+}
+
+void Assignment::ShareFieldChains(FieldChains& chains) {
+    rv_->ShareFieldChains(chains);
+    if (slot_ != MethodScope::NO_SLOT) {
+        chains.AssignVariable(slot_);
+    }
+}
+
+std::unique_ptr<Statement> Assignment::Fuse() {
+    FuseNode(rv_);
+    return nullptr;
+}
+
 Assignment::Assignment(std::string var, std::unique_ptr<Statement> rv) 
     :var_(std::move(var))
     ,rv_(std::move(rv))
 {
 }
 
+FieldPath::FieldPath(std::vector<std::string> field_names) {
+    hops_.reserve(field_names.size());
+    for (std::string& name : field_names) {
+        hops_.push_back({ std::move(name) });
+    }
+}
+
+const ObjectHolder& FieldPath::Resolve(const ObjectHolder& object) {
+    const ObjectHolder* current = &object;
+    for (Hop& hop : hops_) {
+        if (current->GetKind() != runtime::ObjectKind::CLASS_INSTANCE) {
+            break;
+        }
+        auto& instance = current->As<runtime::ClassInstance>();
+        if (const runtime::Shape* shape = instance.GetShape()) {
+            if (shape != hop.shape) {
+                size_t slot = shape->FindSlot(hop.name);
+                if (slot == runtime::Shape::NO_SLOT) {
+                    throw std::runtime_error("Unknown variable name"s);
+                }
+                hop.shape = shape;
+                hop.slot = slot;
+            }
+            current = &instance.GetSlot(hop.slot);
+        }
+        else {
+            current = instance.FindField(hop.name);
+            if (!current) {
+                throw std::runtime_error("Unknown variable name"s);
+            }
+        }
+    }
+    return *current;
+}
+
+const ObjectHolder* FieldPath::ResolveCached(runtime::ClassInstance& object) const {
+    runtime::ClassInstance* instance = &object;
+    const ObjectHolder* current = nullptr;
+    for (const Hop& hop : hops_) {
+        if (current) {
+            instance = current->TryAs<runtime::ClassInstance>();
+            if (!instance) {
+                return nullptr;
+            }
+        }
+        // Поле, к которому ещё не обращались, не имеет запомненной формы
+        if (!hop.shape || instance->GetShape() != hop.shape) {
+            return nullptr;
+        }
+        current = &instance->GetSlot(hop.slot);
+    }
+    return current;
+}
+
+bool FieldPath::Extends(const FieldPath& prefix, const std::string& field_name) const {
+    if (hops_.size() != prefix.hops_.size() + 1 || hops_.back().name != field_name) {
+        return false;
+    }
+    for (size_t i = 0; i < prefix.hops_.size(); ++i) {
+        if (hops_[i].name != prefix.hops_[i].name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<std::string> FieldPath::GetFieldNames() const {
+    std::vector<std::string> names;
+    names.reserve(hops_.size());
+    for (const Hop& hop : hops_) {
+        names.push_back(hop.name);
+    }
+    return names;
+}
+
 VariableValue::VariableValue(const std::string& var_name) 
     :var_name_(std::move(var_name))
 {
@@ -36,30 +333,74 @@ VariableValue::VariableValue(std::vector<std::string> dotted_ids)
     :var_name_(dotted_ids[0])
 {
     if (dotted_ids.size() > 1) {
-        dotted_ids_.reserve(dotted_ids.size() - 1);
-        for (size_t i = 1; i < dotted_ids.size(); ++i) {
-            dotted_ids_.push_back(std::move(dotted_ids[i]));
-        }
+        field_path_ = FieldPath({ std::make_move_iterator(dotted_ids.begin() + 1),
+            std::make_move_iterator(dotted_ids.end()) });
     }
 }
 
 ObjectHolder VariableValue::Execute(Closure& closure, Context& context) {
-    if (closure.count(var_name_)) {
-        runtime::ObjectHolder obj = closure.at(var_name_);
-        if (dotted_ids_.size()>0) {
-            auto class_inst_ptr_ = obj.TryAs<runtime::ClassInstance>();
-            if (class_inst_ptr_) {
-                return VariableValue(dotted_ids_).Execute(class_inst_ptr_->Fields(), context);
-            }
-            else {
-                //throw something?
-            }
+    return Lookup(closure, context);
+}
+
+bool VariableValue::ExecuteAsInt(Closure& closure, Context& context, int& number,
+    ObjectHolder& value) {
+    const ObjectHolder& result = Lookup(closure, context);
+    if (result.GetKind() == ObjectKind::NUMBER) {
+        number = result.GetNumber();
+        return true;
+    }
+    value = result;
+    return false;
+}
+
+const ObjectHolder& VariableValue::Lookup(Closure& closure, Context& context) {
+    if (slot_ != MethodScope::NO_SLOT) {
+        runtime::FrameSlot* frame = context.GetFrame();
+        if (sharing_ == Sharing::LOAD) {
+            // Слот заполнен первым чтением цепочки в том же линейном участке
+            assert(frame[shared_slot_]);
+            return *frame[shared_slot_];
         }
-        return obj;
+        const runtime::FrameSlot& variable = frame[slot_];
+        if (!variable) {
+            throw std::runtime_error("Unknown variable name"s);
+        }
+        const ObjectHolder& value = field_path_.Resolve(*variable);
+        if (sharing_ == Sharing::STORE) {
+            frame[shared_slot_] = value;
+        }
+        return value;
     }
-    else {
+    auto it = closure.find(var_name_);
+    if (it == closure.end()) {
         throw std::runtime_error("Unknown variable name"s);
     }
+    return field_path_.Resolve(it->second);
+}
+
+void VariableValue::ResolveNames(MethodScope& scope) {
+    // Переменная, которой до этого места тела метода не присваивалось значение,
+    // остаётся неизвестной и при выполнении ищется в closure
+    slot_ = scope.FindSlot(var_name_);
+}
+
+void VariableValue::ShareFieldChains(FieldChains& chains) {
+    chains.Read(*this);
+}
+
+void VariableValue::StoreShared(size_t slot) {
+    sharing_ = Sharing::STORE;
+    shared_slot_ = slot;
+}
+
+void VariableValue::LoadShared(size_t slot) {
+    sharing_ = Sharing::LOAD;
+    shared_slot_ = slot;
+}
+
+bool VariableValue::IsFieldOf(const VariableValue& object, const std::string& field_name) const {
+    return var_name_ == object.var_name_ && slot_ == object.slot_
+        && field_path_.Extends(object.field_path_, field_name);
 }
 
 unique_ptr<Print> Print::Variable(const std::string& name) {
@@ -82,20 +423,45 @@ ObjectHolder Print::Execute(Closure& closure, Context& context) {
         if (!first) {
             out << " "s;
         }
-        runtime::ObjectHolder object = var.get()->Execute(closure, context);
-        runtime::Object* obj_ptr_ = object.Get();
-        if (obj_ptr_) {
-            obj_ptr_->Print(out, context);
-        }
-        else {
-            out << "None"s;
-        }
+        PrintValue(var.get()->Execute(closure, context), out, context);
         first = false;
     }
     out << "\n"s;
     return {};
 }
 
+void Print::PrintValue(const ObjectHolder& object, std::ostream& out, Context& context) {
+    runtime::PrintValue(object, out, context);
+}
+
+void Print::ResolveNames(MethodScope& scope) {
+    for (auto& arg : args_) {
+        arg->ResolveNames(scope);
+    }
+}
+
+std::unique_ptr<Statement> Print::Fold() {
+    for (auto& arg : args_) {
+        FoldNode(arg);
+    }
+    return nullptr;
+}
+
+void Print::ShareFieldChains(FieldChains& chains) {
+    // Вывод объекта вызывает его метод __str__
+    for (auto& arg : args_) {
+        arg->ShareFieldChains(chains);
+        chains.Clear();
+    }
+}
+
+std::unique_ptr<Statement> Print::Fuse() {
+    for (auto& arg : args_) {
+        FuseNode(arg);
+    }
+    return nullptr;
+}
+
 MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method,
     std::vector<std::unique_ptr<Statement>> args) 
     :object_(std::move(object))
@@ -104,15 +470,71 @@ MethodCall::MethodCall(std::unique_ptr<Statement> object, std::string method,
 {
 }
 
+ObjectHolder MethodCall::ExecuteInline(const InlineMethod& inline_method,
+    runtime::ClassInstance& instance, Closure& closure, Context& context) {
+    switch (inline_method.kind) {
+    case InlineMethod::Kind::GETTER:
+        return inline_method.path->Resolve(ObjectHolder::Share(instance));
+    case InlineMethod::Kind::SETTER:
+        instance.SetField(inline_method.field_name, args_.front().get()->Execute(closure, context));
+        break;
+    }
+    return ObjectHolder::None();
+}
+
+void MethodCall::ResolveNames(MethodScope& scope) {
+    object_->ResolveNames(scope);
+    for (auto& arg : args_) {
+        arg->ResolveNames(scope);
+    }
+}
+
+std::unique_ptr<Statement> MethodCall::Fold() {
+    FoldNode(object_);
+    for (auto& arg : args_) {
+        FoldNode(arg);
+    }
+    return nullptr;
+}
+
+void MethodCall::ShareFieldChains(FieldChains& chains) {
+    object_->ShareFieldChains(chains);
+    for (auto& arg : args_) {
+        arg->ShareFieldChains(chains);
+    }
+    chains.Clear();
+}
+
+std::unique_ptr<Statement> MethodCall::Fuse() {
+    FuseNode(object_);
+    for (auto& arg : args_) {
+        FuseNode(arg);
+    }
+    return nullptr;
+}
+
 ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
       ObjectHolder obj = object_.get()->Execute(closure, context);
       runtime::ClassInstance* obj_cl = obj.TryAs<runtime::ClassInstance>();
       if (obj_cl) {
-          std::vector<runtime::ObjectHolder> args(args_.size());
-          for (size_t i = 0; i < args.size(); ++i) {
-              args[i] = args_[i].get()->Execute(closure, context);
+          auto [cls, method, cached] = cache_.Find(obj_cl->GetClass(), method_,
+              args_.size(), [](const runtime::Method& found) {
+                  MethodBody* body = MethodBody::GetTranslatable(found);
+                  return CachedMethod{ body ? body->GetInlineMethod() : nullptr, body };
+              });
+          if (cached.inline_method) {
+              return ExecuteInline(*cached.inline_method, *obj_cl, closure, context);
+          }
+          // Аргументы вычисляются сразу в слоты фрейма вызываемого метода
+          runtime::StackFrame frame(context.GetFrameStack(),
+              method ? runtime::ClassInstance::GetFrameSize(*method) : args_.size() + 1);
+          for (size_t i = 0; i < args_.size(); ++i) {
+              frame[i + 1] = args_[i].get()->Execute(closure, context);
+          }
+          if (!method) {
+              throw std::runtime_error("Method not found"s);
           }
-          return obj_cl->Call(method_, args, context);
+          return obj_cl->CallInFrame(*method, frame.Get(), context);
       }
       else {
           throw std::runtime_error("Object must be a ClassInstance to call a method"s);
@@ -120,10 +542,24 @@ ObjectHolder MethodCall::Execute(Closure& closure, Context& context) {
 }
 
 ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
-    runtime::ObjectHolder object = argument_.get()->Execute(closure, context);
+    return Apply(argument_.get()->Execute(closure, context), context);
+}
+
+std::unique_ptr<Statement> Stringify::Fold() {
+    FoldNode(argument_);
+    return IsConstant(*argument_) ? Precompute(*this) : nullptr;
+}
+
+void Stringify::ShareFieldChains(FieldChains& chains) {
+    // Преобразование объекта в строку вызывает его метод __str__
+    UnaryOperation::ShareFieldChains(chains);
+    chains.Clear();
+}
+
+ObjectHolder Stringify::Apply(const ObjectHolder& object, Context& context) {
     if (object) {
         std::ostringstream to_string;
-        object->Print(to_string, context);
+        runtime::PrintValue(object, to_string, context);
         return ObjectHolder::Own(runtime::String(to_string.str()));
         //ObjectHolder<-Object::String<-stream to string<-Print to stream<-ObjectHolder<-Execute<-unique_ptr<-Statement==Executable
     }
@@ -133,70 +569,229 @@ ObjectHolder Stringify::Execute(Closure& closure, Context& context) {
 }
 
 ObjectHolder Add::Execute(Closure& closure, Context& context) {
-    runtime::ObjectHolder left_obj = lhs_.get()->Execute(closure, context);
-    runtime::ObjectHolder right_obj = rhs_.get()->Execute(closure, context);
-    auto left_ptr = left_obj.TryAs<runtime::Number>();
-    auto right_ptr = right_obj.TryAs<runtime::Number>();
-    if (left_ptr && right_ptr) {
-        return runtime::ObjectHolder::Own(runtime::Number(left_ptr->GetValue() + right_ptr->GetValue()));
+    // Сложение чисел вычисляет вложенные выражения без создания промежуточных объектов
+    if (specialization_ == Specialization::NUMBERS
+        || specialization_ == Specialization::UNINITIALIZED) {
+        return ExecuteBoxed(*this, closure, context);
     }
-    auto left_ptr_str = left_obj.TryAs<runtime::String>();
-    auto right_ptr_str = right_obj.TryAs<runtime::String>();
-    if (left_ptr_str && right_ptr_str) {
-        return runtime::ObjectHolder::Own(runtime::String(left_ptr_str->GetValue() + right_ptr_str->GetValue()));
+    const ObjectHolder left_obj = lhs_.get()->Execute(closure, context);
+    const ObjectHolder right_obj = rhs_.get()->Execute(closure, context);
+    return Combine(left_obj, right_obj, context);
+}
+
+bool Add::ExecuteAsInt(Closure& closure, Context& context, int& number, ObjectHolder& value) {
+    const Operand lhs(*lhs_, closure, context);
+    const Operand rhs(*rhs_, closure, context);
+    if (lhs.is_number && rhs.is_number) {
+        ObserveNumbers();
+        number = lhs.number + rhs.number;
+        return true;
+    }
+    return StoreResult(Combine(lhs.Box(), rhs.Box(), context), number, value);
+}
+
+void Add::ShareFieldChains(FieldChains& chains) {
+    // Сложение объекта вызывает его метод __add__
+    BinaryOperation::ShareFieldChains(chains);
+    chains.Clear();
+}
+
+ObjectHolder Add::Combine(const ObjectHolder& left_obj, const ObjectHolder& right_obj,
+    Context& context) {
+    switch (specialization_) {
+    case Specialization::NUMBERS:
+        if (BothOfKind(left_obj, right_obj, ObjectKind::NUMBER)) {
+            auto [lhs, rhs] = NumberValues(left_obj, right_obj);
+            return ObjectHolder::Own(runtime::Number(lhs + rhs));
+        }
+        break;
+    case Specialization::STRINGS:
+        if (BothOfKind(left_obj, right_obj, ObjectKind::STRING)) {
+            return ObjectHolder::Own(runtime::String(left_obj.As<runtime::String>().GetValue()
+                + right_obj.As<runtime::String>().GetValue()));
+        }
+        break;
+    case Specialization::INSTANCE:
+        if (left_obj.GetKind() == ObjectKind::CLASS_INSTANCE
+            && &left_obj.As<runtime::ClassInstance>().GetClass() == instance_class_) {
+            return left_obj.As<runtime::ClassInstance>().Call(*add_method_, { right_obj },
+                context);
+        }
+        break;
+    case Specialization::GENERIC:
+        return runtime::Add(left_obj, right_obj, context);
+    case Specialization::UNINITIALIZED:
+        break;
     }
-    auto left_ptr_class = left_obj.TryAs<runtime::ClassInstance>();
-    if (left_ptr_class) {
-        return left_ptr_class->Call(ADD_METHOD, { right_obj }, context);
+
+    Specialization observed = Observe(left_obj, right_obj);
+    if (observed == Specialization::GENERIC
+        && left_obj.GetKind() == ObjectKind::CLASS_INSTANCE) {
+        const runtime::Class& cls = left_obj.As<runtime::ClassInstance>().GetClass();
+        if (const runtime::Method* m = cls.GetSpecialMethod(runtime::SpecialMethod::ADD, 1)) {
+            observed = Specialization::INSTANCE;
+            instance_class_ = &cls;
+            add_method_ = m;
+        }
     }
-    throw std::runtime_error("Failed to add, check arguments"s);
+    Respecialize(observed);
+    return runtime::Add(left_obj, right_obj, context);
 }
 
 ObjectHolder Sub::Execute(Closure& closure, Context& context) {
-    runtime::ObjectHolder left_obj = lhs_.get()->Execute(closure, context);
-    runtime::ObjectHolder right_obj = rhs_.get()->Execute(closure, context);
-    auto left_ptr = left_obj.TryAs<runtime::Number>();
-    auto right_ptr = right_obj.TryAs<runtime::Number>();
-    if (left_ptr && right_ptr) {
-        return runtime::ObjectHolder::Own(runtime::Number(left_ptr->GetValue() - right_ptr->GetValue()));
+    return ExecuteBoxed(*this, closure, context);
+}
+
+bool Sub::ExecuteAsInt(Closure& closure, Context& context, int& number, ObjectHolder& value) {
+    const Operand lhs(*lhs_, closure, context);
+    const Operand rhs(*rhs_, closure, context);
+    if (lhs.is_number && rhs.is_number) {
+        ObserveNumbers();
+        number = lhs.number - rhs.number;
+        return true;
     }
-    throw std::runtime_error("Failed to sub, check arguments"s);
+    const ObjectHolder left_obj = lhs.Box();
+    const ObjectHolder right_obj = rhs.Box();
+    if (specialization_ != Specialization::GENERIC) {
+        Respecialize(Observe(left_obj, right_obj));
+    }
+    return StoreResult(runtime::Sub(left_obj, right_obj, context), number, value);
 }
 
 ObjectHolder Mult::Execute(Closure& closure, Context& context) {
-    runtime::ObjectHolder left_obj = lhs_.get()->Execute(closure, context);
-    runtime::ObjectHolder right_obj = rhs_.get()->Execute(closure, context);
-    auto left_ptr = left_obj.TryAs<runtime::Number>();
-    auto right_ptr = right_obj.TryAs<runtime::Number>();
-    if (left_ptr && right_ptr) {
-        return runtime::ObjectHolder::Own(runtime::Number(left_ptr->GetValue() * right_ptr->GetValue()));
+    return ExecuteBoxed(*this, closure, context);
+}
+
+std::unique_ptr<Statement> Mult::Fold() {
+    if (auto folded = BinaryOperation::Fold()) {
+        return folded;
     }
-    throw std::runtime_error("Failed to mult, check arguments"s);
+    // Умножение на 1 убирается, только если второй аргумент - число: иначе
+    // умножение завершается ошибкой, которая должна произойти при выполнении
+    auto is_one = [](Statement& node) {
+        auto* constant = dynamic_cast<NumericConst*>(&node);
+        return constant && EvaluateConstant(*constant).GetNumber() == 1;
+    };
+    if (is_one(*rhs_) && IsNumeric(*lhs_)) {
+        return std::move(lhs_);
+    }
+    if (is_one(*lhs_) && IsNumeric(*rhs_)) {
+        return std::move(rhs_);
+    }
+    return nullptr;
+}
+
+bool Mult::ExecuteAsInt(Closure& closure, Context& context, int& number, ObjectHolder& value) {
+    const Operand lhs(*lhs_, closure, context);
+    const Operand rhs(*rhs_, closure, context);
+    if (lhs.is_number && rhs.is_number) {
+        ObserveNumbers();
+        number = lhs.number * rhs.number;
+        return true;
+    }
+    const ObjectHolder left_obj = lhs.Box();
+    const ObjectHolder right_obj = rhs.Box();
+    if (specialization_ != Specialization::GENERIC) {
+        Respecialize(Observe(left_obj, right_obj));
+    }
+    return StoreResult(runtime::Mult(left_obj, right_obj, context), number, value);
 }
 
 ObjectHolder Div::Execute(Closure& closure, Context& context) {
-    runtime::ObjectHolder left_obj = lhs_.get()->Execute(closure, context);
-    runtime::ObjectHolder right_obj = rhs_.get()->Execute(closure, context);
-    auto left_ptr = left_obj.TryAs<runtime::Number>();
-    auto right_ptr = right_obj.TryAs<runtime::Number>();
-    if (left_ptr && right_ptr) {
-        if (right_ptr->GetValue() == 0) {
-            throw std::runtime_error("Failed to divide by 0, can't deal with eternity"s);
+    return ExecuteBoxed(*this, closure, context);
+}
+
+bool Div::ExecuteAsInt(Closure& closure, Context& context, int& number, ObjectHolder& value) {
+    const Operand lhs(*lhs_, closure, context);
+    const Operand rhs(*rhs_, closure, context);
+    if (lhs.is_number && rhs.is_number) {
+        ObserveNumbers();
+        if (rhs.number != 0) {
+            number = lhs.number / rhs.number;
+            return true;
         }
-        return runtime::ObjectHolder::Own(runtime::Number(left_ptr->GetValue() / right_ptr->GetValue()));
     }
-    throw std::runtime_error("Failed to div, check arguments"s);
+    const ObjectHolder left_obj = lhs.Box();
+    const ObjectHolder right_obj = rhs.Box();
+    if (specialization_ != Specialization::GENERIC && !(lhs.is_number && rhs.is_number)) {
+        Respecialize(Observe(left_obj, right_obj));
+    }
+    // Деление на 0 обрабатывается общим случаем
+    return StoreResult(runtime::Div(left_obj, right_obj, context), number, value);
 }
 
 ObjectHolder Compound::Execute(Closure& closure, Context& context) {
+    ObjectHolder return_value;
+    ExecuteStatement(closure, context, return_value);
+    return ObjectHolder::None();
+}
+
+runtime::Completion Compound::ExecuteStatement(Closure& closure, Context& context,
+    ObjectHolder& return_value) {
     for (auto& argument : args_) {
-        argument.get()->Execute(closure, context);
+        if (argument.get()->ExecuteStatement(closure, context, return_value)
+            == runtime::Completion::RETURN) {
+            return runtime::Completion::RETURN;
+        }
     }
-    return ObjectHolder::None();
+    return runtime::Completion::NORMAL;
+}
+
+void Compound::ResolveNames(MethodScope& scope) {
+    for (auto& argument : args_) {
+        argument->ResolveNames(scope);
+    }
+}
+
+std::unique_ptr<Statement> Compound::Fold() {
+    for (auto& argument : args_) {
+        FoldNode(argument);
+    }
+    return nullptr;
+}
+
+void Compound::ShareFieldChains(FieldChains& chains) {
+    for (auto& argument : args_) {
+        argument->ShareFieldChains(chains);
+    }
+}
+
+std::unique_ptr<Statement> Compound::Fuse() {
+    for (auto& argument : args_) {
+        FuseNode(argument);
+    }
+    return nullptr;
 }
 
 ObjectHolder Return::Execute(Closure& closure, Context& context) {
-    throw statement_.get()->Execute(closure, context);
+    return statement_.get()->Execute(closure, context);
+}
+
+runtime::Completion Return::ExecuteStatement(Closure& closure, Context& context,
+    ObjectHolder& return_value) {
+    return_value = statement_.get()->Execute(closure, context);
+    return runtime::Completion::RETURN;
+}
+
+void Return::ResolveNames(MethodScope& scope) {
+    statement_->ResolveNames(scope);
+}
+
+std::unique_ptr<Statement> Return::Fold() {
+    FoldNode(statement_);
+    return nullptr;
+}
+
+void Return::ShareFieldChains(FieldChains& chains) {
+    statement_->ShareFieldChains(chains);
+}
+
+std::unique_ptr<Statement> Return::Fuse() {
+    FuseNode(statement_);
+    if (auto* variable = dynamic_cast<VariableValue*>(statement_.get())) {
+        return std::make_unique<ReturnVariable>(std::move(*variable));
+    }
+    return nullptr;
 }
 
 ClassDefinition::ClassDefinition(ObjectHolder cls) 
@@ -227,12 +822,40 @@ ObjectHolder FieldAssignment::Execute(Closure& closure, Context& context) {
     runtime::ObjectHolder obj = object_.Execute(closure, context);
     auto class_inst_ptr_ = obj.TryAs<runtime::ClassInstance>();
     if (class_inst_ptr_) {
-        class_inst_ptr_->Fields()[field_name_] = rv_.get()->Execute(closure, context);
+        ObjectHolder value = rv_.get()->Execute(closure, context);
+        return class_inst_ptr_->SetField(field_name_, std::move(value));
     }
     else {
-        //may be throw exeption?
+        throw std::runtime_error("Object must be a ClassInstance to assign a field"s);
     }
-    return class_inst_ptr_->Fields().at(field_name_);
+}
+
+void FieldAssignment::ResolveNames(MethodScope& scope) {
+    object_.ResolveNames(scope);
+    rv_->ResolveNames(scope);
+}
+
+std::unique_ptr<Statement> FieldAssignment::Fold() {
+    FoldNode(rv_);
+    return nullptr;
+}
+
+void FieldAssignment::ShareFieldChains(FieldChains& chains) {
+    object_.ShareFieldChains(chains);
+    rv_->ShareFieldChains(chains);
+    chains.AssignField(field_name_);
+}
+
+std::unique_ptr<Statement> FieldAssignment::Fuse() {
+    FuseNode(rv_);
+    if (auto* add = dynamic_cast<Add*>(rv_.get())) {
+        auto* field = dynamic_cast<const VariableValue*>(&add->GetLhs());
+        if (field && field->IsFieldOf(object_, field_name_)) {
+            return std::make_unique<FieldIncrement>(std::move(object_), std::move(field_name_),
+                add->ReleaseRhs());
+        }
+    }
+    return nullptr;
 }
 
 IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement> if_body,
@@ -244,7 +867,7 @@ IfElse::IfElse(std::unique_ptr<Statement> condition, std::unique_ptr<Statement>
 }
 
 ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
-    if (runtime::IsTrue(condition_.get()->Execute(closure, context))) {
+    if (condition_.get()->ExecuteAsBool(closure, context)) {
         return if_body_.get()->Execute(closure, context);
     }
     else {
@@ -257,61 +880,362 @@ ObjectHolder IfElse::Execute(Closure& closure, Context& context) {
     }
 }
 
-ObjectHolder Or::Execute(Closure& closure, Context& context) {
-    ObjectHolder left_obj = lhs_.get()->Execute(closure, context);
-    if (runtime::IsTrue(left_obj)) {
-        return ObjectHolder::Own(runtime::Bool(true));
+runtime::Completion IfElse::ExecuteStatement(Closure& closure, Context& context,
+    ObjectHolder& return_value) {
+    if (condition_.get()->ExecuteAsBool(closure, context)) {
+        return if_body_.get()->ExecuteStatement(closure, context, return_value);
     }
-    else {
-        ObjectHolder right_obj = rhs_.get()->Execute(closure, context);
-        if (runtime::IsTrue(right_obj)) {
-            return ObjectHolder::Own(runtime::Bool(true));
-        }
-        else {
-            return ObjectHolder::Own(runtime::Bool(false));
-        }
+    if (else_body_) {
+        return else_body_.get()->ExecuteStatement(closure, context, return_value);
+    }
+    return runtime::Completion::NORMAL;
+}
 
+void IfElse::ResolveNames(MethodScope& scope) {
+    condition_->ResolveNames(scope);
+    if_body_->ResolveNames(scope);
+    if (else_body_) {
+        else_body_->ResolveNames(scope);
     }
+}
 
+std::unique_ptr<Statement> IfElse::Fold() {
+    FoldCondition(condition_);
+    FoldNode(if_body_);
+    FoldNode(else_body_);
+    if (!IsConstant(*condition_)) {
+        return nullptr;
+    }
+    // Выполняется только одна ветка, поэтому инструкция заменяется этой веткой
+    if (runtime::IsTrue(EvaluateConstant(*condition_))) {
+        return std::move(if_body_);
+    }
+    if (else_body_) {
+        return std::move(else_body_);
+    }
+    return std::make_unique<Compound>();
 }
 
-ObjectHolder And::Execute(Closure& closure, Context& context) {
-    ObjectHolder left_obj = lhs_.get()->Execute(closure, context);
-    if (!runtime::IsTrue(left_obj)) {
-        return ObjectHolder::Own(runtime::Bool(false));
+void IfElse::ShareFieldChains(FieldChains& chains) {
+    // Ветки выполняются не всегда, поэтому каждая - отдельный линейный участок
+    condition_->ShareFieldChains(chains);
+    chains.Clear();
+    if_body_->ShareFieldChains(chains);
+    chains.Clear();
+    if (else_body_) {
+        else_body_->ShareFieldChains(chains);
+        chains.Clear();
     }
-    else {
-        ObjectHolder right_obj = rhs_.get()->Execute(closure, context);
-        if (!runtime::IsTrue(right_obj)) {
-            return ObjectHolder::Own(runtime::Bool(false));
-        }
-        else {
-            return ObjectHolder::Own(runtime::Bool(true));
-        }
+}
 
+std::unique_ptr<Statement> IfElse::Fuse() {
+    FuseNode(condition_);
+    FuseNode(if_body_);
+    FuseNode(else_body_);
+    if (dynamic_cast<Comparison*>(condition_.get())) {
+        return std::make_unique<CompareBranch>(
+            std::unique_ptr<Comparison>(static_cast<Comparison*>(condition_.release())),
+            std::move(if_body_), std::move(else_body_));
     }
+    return nullptr;
+}
+
+void UnaryOperation::ResolveNames(MethodScope& scope) {
+    argument_->ResolveNames(scope);
+}
+
+std::unique_ptr<Statement> UnaryOperation::Fold() {
+    FoldNode(argument_);
+    return nullptr;
+}
+
+void UnaryOperation::ShareFieldChains(FieldChains& chains) {
+    argument_->ShareFieldChains(chains);
+}
+
+std::unique_ptr<Statement> UnaryOperation::Fuse() {
+    FuseNode(argument_);
+    return nullptr;
+}
+
+void BinaryOperation::ResolveNames(MethodScope& scope) {
+    lhs_->ResolveNames(scope);
+    rhs_->ResolveNames(scope);
+}
+
+BinaryOperation::Specialization BinaryOperation::Observe(const ObjectHolder& lhs,
+    const ObjectHolder& rhs) {
+    if (BothOfKind(lhs, rhs, ObjectKind::NUMBER)) {
+        return Specialization::NUMBERS;
+    }
+    if (BothOfKind(lhs, rhs, ObjectKind::STRING)) {
+        return Specialization::STRINGS;
+    }
+    return Specialization::GENERIC;
+}
+
+std::unique_ptr<Statement> BinaryOperation::Fold() {
+    FoldNode(lhs_);
+    FoldNode(rhs_);
+    if (IsConstant(*lhs_) && IsConstant(*rhs_)) {
+        return Precompute(*this);
+    }
+    return nullptr;
+}
+
+void BinaryOperation::ShareFieldChains(FieldChains& chains) {
+    lhs_->ShareFieldChains(chains);
+    rhs_->ShareFieldChains(chains);
+}
+
+std::unique_ptr<Statement> BinaryOperation::Fuse() {
+    FuseNode(lhs_);
+    FuseNode(rhs_);
+    return nullptr;
+}
+
+ObjectHolder Or::Execute(Closure& closure, Context& context) {
+    return ExecuteAsBool(closure, context) ? ObjectHolder::True() : ObjectHolder::False();
+}
+
+std::unique_ptr<Statement> Or::Fold() {
+    FoldCondition(lhs_);
+    FoldCondition(rhs_);
+    if (!IsConstant(*lhs_)) {
+        return nullptr;
+    }
+    // Если левый аргумент ложен, результат - истинность правого
+    if (runtime::IsTrue(EvaluateConstant(*lhs_))) {
+        return std::make_unique<BoolConst>(true);
+    }
+    if (IsBoolean(*rhs_)) {
+        return std::move(rhs_);
+    }
+    return IsConstant(*rhs_) ? Precompute(*this) : nullptr;
+}
+
+void Or::ShareFieldChains(FieldChains& chains) {
+    // Правый аргумент вычисляется не всегда
+    BinaryOperation::ShareFieldChains(chains);
+    chains.Clear();
+}
+
+bool Or::ExecuteAsBool(Closure& closure, Context& context) {
+    return lhs_.get()->ExecuteAsBool(closure, context)
+        || rhs_.get()->ExecuteAsBool(closure, context);
+}
+
+ObjectHolder And::Execute(Closure& closure, Context& context) {
+    return ExecuteAsBool(closure, context) ? ObjectHolder::True() : ObjectHolder::False();
+}
+
+std::unique_ptr<Statement> And::Fold() {
+    FoldCondition(lhs_);
+    FoldCondition(rhs_);
+    if (!IsConstant(*lhs_)) {
+        return nullptr;
+    }
+    // Если левый аргумент истинен, результат - истинность правого
+    if (!runtime::IsTrue(EvaluateConstant(*lhs_))) {
+        return std::make_unique<BoolConst>(false);
+    }
+    if (IsBoolean(*rhs_)) {
+        return std::move(rhs_);
+    }
+    return IsConstant(*rhs_) ? Precompute(*this) : nullptr;
+}
+
+void And::ShareFieldChains(FieldChains& chains) {
+    // Правый аргумент вычисляется не всегда
+    BinaryOperation::ShareFieldChains(chains);
+    chains.Clear();
+}
+
+bool And::ExecuteAsBool(Closure& closure, Context& context) {
+    return lhs_.get()->ExecuteAsBool(closure, context)
+        && rhs_.get()->ExecuteAsBool(closure, context);
 }
 
 ObjectHolder Not::Execute(Closure& closure, Context& context) {
-    ObjectHolder obj = argument_.get()->Execute(closure, context);
+    return ExecuteAsBool(closure, context) ? ObjectHolder::True() : ObjectHolder::False();
+}
+
+std::unique_ptr<Statement> Not::Fold() {
+    FoldCondition(argument_);
+    if (IsConstant(*argument_)) {
+        return Precompute(*this);
+    }
+    // not not x равно x, только если значение x - True либо False
+    if (auto* inner = dynamic_cast<Not*>(argument_.get()); inner && IsBoolean(inner->GetArgument())) {
+        return inner->ReleaseArgument();
+    }
+    return nullptr;
+}
+
+bool Not::ExecuteAsBool(Closure& closure, Context& context) {
+    return !argument_.get()->ExecuteAsBool(closure, context);
+}
+
+ObjectHolder Not::Apply(const ObjectHolder& obj) {
     if (runtime::IsTrue(obj)) {
-        return ObjectHolder::Own(runtime::Bool(false));
+        return ObjectHolder::False();
     }
     else {
-        return ObjectHolder::Own(runtime::Bool(true));
+        return ObjectHolder::True();
     }
 }
 
 Comparison::Comparison(Comparator cmp, unique_ptr<Statement> lhs, unique_ptr<Statement> rhs)
     : BinaryOperation(std::move(lhs), std::move(rhs)) 
-    , comp_(std::move(cmp))
+    , comp_(cmp)
+    , operator_(IdentifyOperator(comp_))
 {
 }
 
+Comparison::Operator Comparison::IdentifyOperator(const Comparator& cmp) {
+    if (cmp == &runtime::Less) {
+        return Operator::LESS;
+    }
+    if (cmp == &runtime::Greater) {
+        return Operator::GREATER;
+    }
+    if (cmp == &runtime::Equal) {
+        return Operator::EQUAL;
+    }
+    if (cmp == &runtime::NotEqual) {
+        return Operator::NOT_EQUAL;
+    }
+    if (cmp == &runtime::LessOrEqual) {
+        return Operator::LESS_OR_EQUAL;
+    }
+    if (cmp == &runtime::GreaterOrEqual) {
+        return Operator::GREATER_OR_EQUAL;
+    }
+    return Operator::OTHER;
+}
+
+template <typename T>
+bool Comparison::Compare(const T& lhs, const T& rhs) const {
+    switch (operator_) {
+    case Operator::LESS:
+        return lhs < rhs;
+    case Operator::GREATER:
+        return rhs < lhs;
+    case Operator::EQUAL:
+        return lhs == rhs;
+    case Operator::NOT_EQUAL:
+        return !(lhs == rhs);
+    case Operator::LESS_OR_EQUAL:
+        return !(rhs < lhs);
+    case Operator::GREATER_OR_EQUAL:
+        return !(lhs < rhs);
+    case Operator::OTHER:
+        break;
+    }
+    assert(false);
+    return false;
+}
+
+bool Comparison::Dispatch(const ObjectHolder& lhs, const ObjectHolder& rhs,
+    Context& context) const {
+    switch (operator_) {
+    case Operator::LESS:
+        return runtime::Less(lhs, rhs, context);
+    case Operator::GREATER:
+        return runtime::Greater(lhs, rhs, context);
+    case Operator::EQUAL:
+        return runtime::Equal(lhs, rhs, context);
+    case Operator::NOT_EQUAL:
+        return runtime::NotEqual(lhs, rhs, context);
+    case Operator::LESS_OR_EQUAL:
+        return runtime::LessOrEqual(lhs, rhs, context);
+    case Operator::GREATER_OR_EQUAL:
+        return runtime::GreaterOrEqual(lhs, rhs, context);
+    case Operator::OTHER:
+        break;
+    }
+    return comp_(lhs, rhs, context);
+}
+
+bool Comparison::CompareValues(const ObjectHolder& lhs, const ObjectHolder& rhs,
+    Context& context) const {
+    if (operator_ != Operator::OTHER) {
+        if (BothOfKind(lhs, rhs, ObjectKind::NUMBER)) {
+            auto [left, right] = NumberValues(lhs, rhs);
+            return Compare(left, right);
+        }
+        if (BothOfKind(lhs, rhs, ObjectKind::STRING)) {
+            return Compare(lhs.As<runtime::String>().GetValue(),
+                rhs.As<runtime::String>().GetValue());
+        }
+    }
+    return Dispatch(lhs, rhs, context);
+}
+
 ObjectHolder Comparison::Execute(Closure& closure, Context& context) {
-    const runtime::ObjectHolder left = lhs_.get()->Execute(closure, context);
-    const runtime::ObjectHolder right = rhs_.get()->Execute(closure, context);
-    return runtime::ObjectHolder::Own(runtime::Bool(comp_(left, right, context)));
+    return runtime::ObjectHolder::Own(runtime::Bool(Test(closure, context)));
+}
+
+std::unique_ptr<Statement> Comparison::Fold() {
+    // Произвольный компаратор может иметь побочные эффекты
+    if (operator_ == Operator::OTHER) {
+        FoldNode(lhs_);
+        FoldNode(rhs_);
+        return nullptr;
+    }
+    return BinaryOperation::Fold();
+}
+
+void Comparison::ShareFieldChains(FieldChains& chains) {
+    // Сравнение объектов вызывает их методы __eq__, __lt__ и т.д.
+    BinaryOperation::ShareFieldChains(chains);
+    chains.Clear();
+}
+
+ObjectHolder Comparison::Apply(const ObjectHolder& lhs, const ObjectHolder& rhs,
+    Context& context) const {
+    return runtime::ObjectHolder::Own(runtime::Bool(CompareValues(lhs, rhs, context)));
+}
+
+bool Comparison::Test(Closure& closure, Context& context) {
+    ObjectHolder left;
+    ObjectHolder right;
+    if (operator_ != Operator::OTHER && (specialization_ == Specialization::NUMBERS
+        || specialization_ == Specialization::UNINITIALIZED)) {
+        // Числа сравниваются без создания объектов Number
+        const Operand lhs(*lhs_, closure, context);
+        const Operand rhs(*rhs_, closure, context);
+        if (lhs.is_number && rhs.is_number) {
+            ObserveNumbers();
+            return Compare(lhs.number, rhs.number);
+        }
+        left = lhs.Box();
+        right = rhs.Box();
+    }
+    else {
+        left = lhs_.get()->Execute(closure, context);
+        right = rhs_.get()->Execute(closure, context);
+    }
+    switch (specialization_) {
+    case Specialization::NUMBERS:
+        if (BothOfKind(left, right, ObjectKind::NUMBER)) {
+            auto [lhs, rhs] = NumberValues(left, right);
+            return Compare(lhs, rhs);
+        }
+        break;
+    case Specialization::STRINGS:
+        if (BothOfKind(left, right, ObjectKind::STRING)) {
+            return Compare(left.As<runtime::String>().GetValue(),
+                right.As<runtime::String>().GetValue());
+        }
+        break;
+    case Specialization::GENERIC:
+        return CompareValues(left, right, context);
+    default:
+        break;
+    }
+    Respecialize(operator_ != Operator::OTHER ? Observe(left, right) : Specialization::GENERIC);
+    return CompareValues(left, right, context);
 }
 
 NewInstance::NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args) 
@@ -326,29 +1250,235 @@ NewInstance::NewInstance(const runtime::Class& class_)
 }
 
 ObjectHolder NewInstance::Execute(Closure& closure, Context& context) {
-    if (class_p_.HasMethod(INIT_METHOD, args_.size())) {
-        std::vector<runtime::ObjectHolder> args_object(args_.size());
+    if (const runtime::Method* init
+        = class_p_.GetClass().GetSpecialMethod(runtime::SpecialMethod::INIT, args_.size())) {
+        runtime::StackFrame frame(context.GetFrameStack(),
+            runtime::ClassInstance::GetFrameSize(*init));
         for (size_t i = 0; i < args_.size(); ++i) {
-            args_object[i] = args_[i].get()->Execute(closure, context);
+            frame[i + 1] = args_[i].get()->Execute(closure, context);
         }
-        class_p_.Call(INIT_METHOD, args_object, context);
+        class_p_.CallInFrame(*init, frame.Get(), context);
     }
     return ObjectHolder::Share(class_p_);
 }
 
+void NewInstance::ResolveNames(MethodScope& scope) {
+    for (auto& arg : args_) {
+        arg->ResolveNames(scope);
+    }
+}
+
+std::unique_ptr<Statement> NewInstance::Fold() {
+    for (auto& arg : args_) {
+        FoldNode(arg);
+    }
+    return nullptr;
+}
+
+void NewInstance::ShareFieldChains(FieldChains& chains) {
+    for (auto& arg : args_) {
+        arg->ShareFieldChains(chains);
+    }
+    chains.Clear();
+}
+
+std::unique_ptr<Statement> NewInstance::Fuse() {
+    for (auto& arg : args_) {
+        FuseNode(arg);
+    }
+    return nullptr;
+}
+
 MethodBody::MethodBody(std::unique_ptr<Statement>&& body) 
     :body_(std::move(body))
 {
 }
 
+MethodBody::~MethodBody() = default;
+
+MethodBody* MethodBody::GetTranslatable(const runtime::Method& method) {
+    if (method.frame_size == 0) {
+        return nullptr;
+    }
+    return dynamic_cast<MethodBody*>(method.body.get());
+}
+
 ObjectHolder MethodBody::Execute(Closure& closure, Context& context) {
-    try {
-        body_.get()->Execute(closure, context);
-        return runtime::ObjectHolder::None();
+    if (native_code_) {
+        // Если параметры не числа либо встретилось деление на 0, метод выполняется обходом AST
+        if (auto result = native_code_->Run(context.GetFrame())) {
+            return std::move(*result);
+        }
     }
-    catch (runtime::ObjectHolder& object) {
-        return object;
+    else if (param_count_ && call_count_ < jit::HOT_CALL_THRESHOLD
+        && ++call_count_ == jit::HOT_CALL_THRESHOLD) {
+        native_code_ = jit::Compile(*body_, *param_count_);
     }
+
+    ObjectHolder return_value;
+    if (body_.get()->ExecuteStatement(closure, context, return_value)
+        == runtime::Completion::RETURN) {
+        return return_value;
+    }
+    return runtime::ObjectHolder::None();
+}
+
+const jit::NativeCode* MethodBody::GetNativeCode() {
+    if (param_count_ && call_count_ < jit::HOT_CALL_THRESHOLD) {
+        call_count_ = jit::HOT_CALL_THRESHOLD;
+        native_code_ = jit::Compile(*body_, *param_count_);
+    }
+    return native_code_.get();
+}
+
+void MethodBody::ResolveNames(MethodScope& scope) {
+    body_->ResolveNames(scope);
+}
+
+std::unique_ptr<Statement> MethodBody::Fold() {
+    FoldNode(body_);
+    return nullptr;
+}
+
+std::unique_ptr<Statement> MethodBody::Fuse() {
+    FuseNode(body_);
+    inline_method_ = FindInlineMethod();
+    return nullptr;
+}
+
+std::optional<InlineMethod> MethodBody::FindInlineMethod() {
+    // Тело метода должно состоять из одной инструкции, а self - быть в слоте 0
+    // (параметр с именем self заменяет self)
+    auto* compound = dynamic_cast<Compound*>(body_.get());
+    if (!param_count_ || !compound || compound->GetStatements().size() != 1) {
+        return std::nullopt;
+    }
+    Statement& statement = *compound->GetStatements().front();
+    if (auto* getter = dynamic_cast<ReturnVariable*>(&statement)) {
+        VariableValue& variable = getter->GetVariable();
+        if (*param_count_ == 0 && variable.GetSlot() == 0) {
+            return InlineMethod{ InlineMethod::Kind::GETTER, &variable.GetFieldPath(), {} };
+        }
+    }
+    else if (auto* setter = dynamic_cast<const FieldAssignment*>(&statement)) {
+        auto* value = dynamic_cast<const VariableValue*>(&setter->GetValue());
+        const VariableValue& object = setter->GetObject();
+        if (*param_count_ == 1 && value && value->GetSlot() == 1 && value->GetFieldPath().IsEmpty()
+            && object.GetSlot() == 0 && object.GetFieldPath().IsEmpty()) {
+            return InlineMethod{ InlineMethod::Kind::SETTER, nullptr, setter->GetFieldName() };
+        }
+    }
+    return std::nullopt;
+}
+
+void MethodBody::ShareFieldChains(FieldChains& chains) {
+    body_->ShareFieldChains(chains);
+}
+
+size_t MethodBody::ShareRepeatedFieldChains(size_t frame_size) {
+    FieldChains chains(frame_size);
+    ShareFieldChains(chains);
+    return chains.GetFrameSize();
+}
+
+size_t MethodBody::ResolveFrame(const std::vector<std::string>& formal_params) {
+    MethodScope scope(formal_params);
+    ResolveNames(scope);
+    param_count_ = formal_params.size();
+    return scope.GetFrameSize();
+}
+
+FieldIncrement::FieldIncrement(VariableValue object, std::string field_name,
+    std::unique_ptr<Statement> increment)
+    : object_(std::move(object))
+    , field_name_(std::move(field_name))
+    , increment_(std::move(increment))
+{
+}
+
+ObjectHolder FieldIncrement::Execute(Closure& closure, Context& context) {
+    ObjectHolder obj = object_.Execute(closure, context);
+    auto* instance = obj.TryAs<runtime::ClassInstance>();
+    if (!instance) {
+        throw std::runtime_error("Object must be a ClassInstance to assign a field"s);
+    }
+
+    const runtime::Shape* shape = instance->GetShape();
+    const ObjectHolder* field = nullptr;
+    if (shape) {
+        if (shape != shape_) {
+            const size_t slot = shape->FindSlot(field_name_);
+            if (slot == runtime::Shape::NO_SLOT) {
+                throw std::runtime_error("Unknown variable name"s);
+            }
+            shape_ = shape;
+            slot_ = slot;
+        }
+        field = &instance->GetSlot(slot_);
+    }
+    else {
+        field = instance->FindField(field_name_);
+        if (!field) {
+            throw std::runtime_error("Unknown variable name"s);
+        }
+    }
+
+    // Значение поля копируется до вычисления increment, которое может изменить объект
+    const ObjectHolder value = *field;
+    const ObjectHolder increment = increment_.get()->Execute(closure, context);
+    ObjectHolder result = runtime::Add(value, increment, context);
+    if (shape && instance->GetShape() == shape) {
+        return instance->GetSlot(slot_) = std::move(result);
+    }
+    return instance->SetField(field_name_, std::move(result));
+}
+
+CompareBranch::CompareBranch(std::unique_ptr<Comparison> condition,
+    std::unique_ptr<Statement> if_body, std::unique_ptr<Statement> else_body)
+    : IfElse(nullptr, std::move(if_body), std::move(else_body))
+    , comparison_(condition.get())
+{
+    condition_ = std::move(condition);
+}
+
+ObjectHolder CompareBranch::Execute(Closure& closure, Context& context) {
+    if (comparison_->Test(closure, context)) {
+        return if_body_.get()->Execute(closure, context);
+    }
+    if (else_body_) {
+        return else_body_.get()->Execute(closure, context);
+    }
+    return runtime::ObjectHolder::None();
+}
+
+runtime::Completion CompareBranch::ExecuteStatement(Closure& closure, Context& context,
+    ObjectHolder& return_value) {
+    if (comparison_->Test(closure, context)) {
+        return if_body_.get()->ExecuteStatement(closure, context, return_value);
+    }
+    if (else_body_) {
+        return else_body_.get()->ExecuteStatement(closure, context, return_value);
+    }
+    return runtime::Completion::NORMAL;
+}
+
+ReturnVariable::ReturnVariable(VariableValue variable)
+    : variable_(std::move(variable))
+{
+}
+
+ObjectHolder ReturnVariable::Execute(Closure& closure, Context& context) {
+    return variable_.Execute(closure, context);
+}
+
+void ReturnVariable::ShareFieldChains(FieldChains& chains) {
+    variable_.ShareFieldChains(chains);
+}
+
+runtime::Completion ReturnVariable::ExecuteStatement(Closure& closure, Context& context,
+    ObjectHolder& return_value) {
+    return_value = variable_.Execute(closure, context);
+    return runtime::Completion::RETURN;
 }
 
 }  // namespace ast
\ No newline at end of file
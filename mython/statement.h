@@ -1,12 +1,179 @@
 ﻿#pragma once
 
+#include "call_site.h"
 #include "runtime.h"
 
-#include <functional>
+#include <array>
+#include <optional>
+#include <unordered_map>
+
+namespace vm {
+class Compiler;
+}  // namespace vm
+
+namespace jit {
+class Emitter;
+class NativeCode;
+enum class ValueType : std::uint8_t;
+}  // namespace jit
+
+namespace aot {
+class Generator;
+}  // namespace aot
+
+namespace flat {
+class Builder;
+}  // namespace flat
 
 namespace ast {
 
-using Statement = runtime::Executable;
+/*
+Назначает переменным метода слоты во фрейме вызова. Слот 0 занимает self, за ним следуют
+формальные параметры, затем локальные переменные в порядке первого присваивания
+*/
+class MethodScope {
+public:
+    // Слот переменной, которая не хранится во фрейме
+    static constexpr size_t NO_SLOT = static_cast<size_t>(-1);
+
+    explicit MethodScope(const std::vector<std::string>& formal_params);
+
+    // Возвращает слот переменной name либо NO_SLOT, если ей ещё не назначен слот
+    [[nodiscard]] size_t FindSlot(const std::string& name) const;
+
+    // Возвращает слот переменной name, назначая новый слот при первом обращении
+    size_t DeclareSlot(const std::string& name);
+
+    // Возвращает количество назначенных слотов
+    [[nodiscard]] size_t GetFrameSize() const {
+        return frame_size_;
+    }
+
+private:
+    std::unordered_map<std::string, size_t> slots_;
+    size_t frame_size_ = 0;
+};
+
+class VariableValue;
+
+/*
+Чтения цепочек полей (self.a.b.c) в линейном участке тела метода. Первое чтение цепочки,
+которую затем читают повторно, сохраняет её значение в скрытом слоте фрейма, а повторные
+чтения берут значение из слота, если между ними нет инструкций, которые могут изменить
+поля цепочки: присваивания полю с именем из цепочки либо вызова метода.
+Скрытый слот владеет значением цепочки, поэтому объект, на который она указывает,
+не удаляется до завершения вызова метода и снятия его фрейма со стека
+*/
+class FieldChains {
+public:
+    // Наименьшее число полей цепочки, значение которой сохраняется в слоте
+    static constexpr size_t MIN_LENGTH = 2;
+
+    // Скрытые слоты назначаются после слотов фрейма с номерами меньше frame_size
+    explicit FieldChains(size_t frame_size)
+        : frame_size_(frame_size) {
+    }
+
+    // Учитывает чтение цепочки полей выражением variable
+    void Read(VariableValue& variable);
+
+    // Забывает цепочки, которые начинаются с переменной в слоте slot
+    void AssignVariable(size_t slot);
+
+    // Забывает цепочки, содержащие поле field_name
+    void AssignField(const std::string& field_name);
+
+    // Забывает все цепочки. Используется после инструкций, которые могут выполнить
+    // метод пользователя, и на границах линейных участков
+    void Clear() {
+        chains_.clear();
+    }
+
+    // Возвращает размер фрейма вместе со скрытыми слотами
+    [[nodiscard]] size_t GetFrameSize() const {
+        return frame_size_;
+    }
+
+private:
+    struct Chain {
+        size_t root_slot;
+        std::vector<std::string> field_names;
+        VariableValue* first_read;
+        size_t shared_slot = MethodScope::NO_SLOT;
+    };
+
+    std::vector<Chain> chains_;
+    size_t frame_size_;
+};
+
+// Инструкция либо выражение программы на Mython
+class Statement : public runtime::Executable {
+public:
+    // Назначает слоты переменным метода, к которым обращается инструкция.
+    // Выполняется один раз после разбора тела метода
+    virtual void ResolveNames([[maybe_unused]] MethodScope& scope) {
+    }
+
+    // Заменяет часто встречающиеся сочетания узлов внутри инструкции объединёнными узлами
+    // (суперинструкциями), которые выполняют ту же работу за один вызов Execute.
+    // Возвращает узел, которым нужно заменить саму инструкцию, либо nullptr.
+    // Выполняется один раз после ResolveNames
+    virtual std::unique_ptr<Statement> Fuse() {
+        return nullptr;
+    }
+
+    // Вычисляет константные выражения внутри инструкции и упрощает её (например, x * 1).
+    // Возвращает узел, которым нужно заменить саму инструкцию, либо nullptr.
+    // Выполняется один раз после разбора, до ResolveNames
+    virtual std::unique_ptr<Statement> Fold() {
+        return nullptr;
+    }
+
+    // Находит в инструкции повторные чтения цепочек полей (см. FieldChains).
+    // По умолчанию забывает все цепочки: инструкция может изменить поля объектов.
+    // Выполняется один раз для тел методов после Fuse
+    virtual void ShareFieldChains(FieldChains& chains) {
+        chains.Clear();
+    }
+
+    // Добавляет в байт-код инструкции, которые оставляют значение инструкции на вершине стека.
+    // По умолчанию добавляет инструкцию, выполняющую саму инструкцию (метод Execute)
+    virtual void Compile(vm::Compiler& compiler);
+
+    // Добавляет машинный код инструкции и возвращает тип вычисленного значения.
+    // По умолчанию возвращает ValueType::UNSUPPORTED: инструкция не транслируется
+    virtual jit::ValueType EmitNative(jit::Emitter& emitter);
+
+    // Добавляет в функцию C++ код, вычисляющий инструкцию, и возвращает выражение C++
+    // с её значением. По умолчанию выбрасывает исключение runtime_error: инструкция
+    // не транслируется в C++
+    virtual std::string Transpile(aot::Generator& generator);
+
+    // Добавляет в дерево узлы инструкции и возвращает номер корневого из них.
+    // По умолчанию добавляет узел, выполняющий саму инструкцию (метод Execute)
+    virtual std::uint32_t Flatten(flat::Builder& builder);
+};
+
+// Добавляет в байт-код инструкцию, которая помещает value на вершину стека
+void CompileConstant(vm::Compiler& compiler, runtime::ObjectHolder value);
+
+// Добавляют машинный код, загружающий константу value
+jit::ValueType EmitNativeConstant(jit::Emitter& emitter, const runtime::Number& value);
+jit::ValueType EmitNativeConstant(jit::Emitter& emitter, const runtime::Bool& value);
+
+// Возвращают выражение C++, значение которого - константа value
+std::string TranspileConstant(aot::Generator& generator, const runtime::Number& value);
+std::string TranspileConstant(aot::Generator& generator, const runtime::String& value);
+std::string TranspileConstant(aot::Generator& generator, const runtime::Bool& value);
+
+// Добавляет в дерево узел-константу value и возвращает его номер
+std::uint32_t FlattenConstant(flat::Builder& builder, runtime::ObjectHolder value);
+
+// Объединяет узлы внутри node и заменяет node объединённым узлом, если он получен
+void FuseNode(std::unique_ptr<Statement>& node);
+
+// Упрощает node и заменяет его упрощённым узлом, если он получен
+void FoldNode(std::unique_ptr<Statement>& node);
 
 // Выражение, возвращающее значение типа T,
 // используется как основа для создания констант
@@ -19,10 +186,64 @@ public:
 
     runtime::ObjectHolder Execute(runtime::Closure& /*closure*/,
         runtime::Context& /*context*/) override {
-        return runtime::ObjectHolder::Share(value_);
+        return GetHolder();
+    }
+
+    bool ExecuteAsBool(runtime::Closure& closure, runtime::Context& context) override {
+        if constexpr (std::is_same_v<T, runtime::Bool>) {
+            return value_.GetValue();
+        }
+        else {
+            return Statement::ExecuteAsBool(closure, context);
+        }
+    }
+
+    bool ExecuteAsInt(runtime::Closure& closure, runtime::Context& context, int& number,
+        runtime::ObjectHolder& value) override {
+        if constexpr (std::is_same_v<T, runtime::Number>) {
+            number = value_.GetValue();
+            return true;
+        }
+        else {
+            return Statement::ExecuteAsInt(closure, context, number, value);
+        }
+    }
+
+    void Compile(vm::Compiler& compiler) override {
+        CompileConstant(compiler, GetHolder());
+    }
+
+    jit::ValueType EmitNative(jit::Emitter& emitter) override {
+        if constexpr (std::is_same_v<T, runtime::Number> || std::is_same_v<T, runtime::Bool>) {
+            return EmitNativeConstant(emitter, value_);
+        }
+        else {
+            return Statement::EmitNative(emitter);
+        }
+    }
+
+    std::string Transpile(aot::Generator& generator) override {
+        return TranspileConstant(generator, value_);
+    }
+
+    std::uint32_t Flatten(flat::Builder& builder) override {
+        return FlattenConstant(builder, GetHolder());
+    }
+
+    void ShareFieldChains(FieldChains& /*chains*/) override {
     }
 
 private:
+    runtime::ObjectHolder GetHolder() {
+        // Числа и логические значения копируются в ObjectHolder без выделения памяти
+        if constexpr (std::is_same_v<T, runtime::Number> || std::is_same_v<T, runtime::Bool>) {
+            return runtime::ObjectHolder::Own(T(value_));
+        }
+        else {
+            return runtime::ObjectHolder::Share(value_);
+        }
+    }
+
     T value_;
 };
 
@@ -30,6 +251,48 @@ using NumericConst = ValueStatement<runtime::Number>;
 using StringConst = ValueStatement<runtime::String>;
 using BoolConst = ValueStatement<runtime::Bool>;
 
+/*
+Цепочка полей id2.id3... в выражении id1.id2.id3. Для каждого поля цепочка запоминает
+форму объекта и номер слота, найденные при последнем обращении, поэтому повторное
+обращение к объектам той же формы не ищет поля по имени
+*/
+class FieldPath {
+public:
+    FieldPath() = default;
+    explicit FieldPath(std::vector<std::string> field_names);
+
+    // Возвращает значение, полученное из object последовательным обращением к полям цепочки.
+    // Если очередной объект не является экземпляром класса, возвращает этот объект.
+    // Если поля нет, выбрасывает исключение runtime_error
+    const runtime::ObjectHolder& Resolve(const runtime::ObjectHolder& object);
+
+    // Возвращает значение цепочки полей object, обращаясь к слотам, запомненным методом
+    // Resolve, без поиска полей по имени. Возвращает nullptr, если форма одного из объектов
+    // цепочки отличается от запомненной либо очередной объект - не экземпляр класса.
+    // Используется машинным кодом (см. jit::Emitter::LoadField)
+    [[nodiscard]] const runtime::ObjectHolder* ResolveCached(runtime::ClassInstance& object) const;
+
+    // Возвращает true, если цепочка не содержит полей
+    [[nodiscard]] bool IsEmpty() const {
+        return hops_.empty();
+    }
+
+    // Возвращает true, если цепочка состоит из полей prefix, за которыми следует поле field_name
+    [[nodiscard]] bool Extends(const FieldPath& prefix, const std::string& field_name) const;
+
+    // Возвращает имена полей цепочки
+    [[nodiscard]] std::vector<std::string> GetFieldNames() const;
+
+private:
+    struct Hop {
+        std::string name;
+        const runtime::Shape* shape = nullptr;
+        size_t slot = 0;
+    };
+
+    std::vector<Hop> hops_;
+};
+
 /*
 Вычисляет значение переменной либо цепочки вызовов полей объектов id1.id2.id3.
 Например, выражение circle.center.x - цепочка вызовов полей объектов в инструкции:
@@ -41,10 +304,56 @@ public:
     explicit VariableValue(std::vector<std::string> dotted_ids);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteAsInt(runtime::Closure& closure, runtime::Context& context, int& number,
+        runtime::ObjectHolder& value) override;
+    void ResolveNames(MethodScope& scope) override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
+
+    // Возвращает true, если выражение обращается к полю field_name значения выражения object
+    [[nodiscard]] bool IsFieldOf(const VariableValue& object, const std::string& field_name) const;
+
+    // Возвращает слот переменной во фрейме метода либо NO_SLOT
+    [[nodiscard]] size_t GetSlot() const {
+        return slot_;
+    }
+
+    // Возвращает цепочку полей, к которым обращается выражение
+    FieldPath& GetFieldPath() {
+        return field_path_;
+    }
+
+    [[nodiscard]] const FieldPath& GetFieldPath() const {
+        return field_path_;
+    }
+
+    // Значение цепочки полей сохраняется в скрытом слоте slot фрейма для повторных чтений
+    void StoreShared(size_t slot);
+
+    // Значение цепочки полей берётся из скрытого слота slot, в котором его сохранило
+    // предыдущее чтение той же цепочки
+    void LoadShared(size_t slot);
 
 private:
+    // Возвращает значение переменной либо цепочки полей без копирования
+    const runtime::ObjectHolder& Lookup(runtime::Closure& closure, runtime::Context& context);
+
+    // Использование скрытого слота со значением цепочки полей (см. FieldChains)
+    enum class Sharing : std::uint8_t {
+        NONE,
+        STORE,
+        LOAD,
+    };
+
     std::string var_name_;
-    std::vector<std::string> dotted_ids_;
+    // Слот переменной во фрейме метода либо NO_SLOT, если переменная ищется в closure
+    size_t slot_ = MethodScope::NO_SLOT;
+    FieldPath field_path_;
+    Sharing sharing_ = Sharing::NONE;
+    size_t shared_slot_ = MethodScope::NO_SLOT;
 };
 
 // Присваивает переменной, имя которой задано в параметре var, значение выражения rv
@@ -53,9 +362,18 @@ public:
     Assignment(std::string var, std::unique_ptr<Statement> rv);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
 private:
     std::string var_;
     std::unique_ptr<Statement>rv_ = nullptr;
+    size_t slot_ = MethodScope::NO_SLOT;
 };
 
 // Присваивает полю object.field_name значение выражения rv
@@ -64,6 +382,31 @@ public:
     FieldAssignment(VariableValue object, std::string field_name, std::unique_ptr<Statement> rv);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+
+    // Присваивание вида object.field = object.field + value заменяется узлом FieldIncrement
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+
+    // Возвращает выражение, поле значения которого присваивается
+    [[nodiscard]] const VariableValue& GetObject() const {
+        return object_;
+    }
+
+    // Возвращает имя присваиваемого поля
+    [[nodiscard]] const std::string& GetFieldName() const {
+        return field_name_;
+    }
+
+    // Возвращает присваиваемое выражение
+    [[nodiscard]] const Statement& GetValue() const {
+        return *rv_;
+    }
+
 private:
     VariableValue object_;
     std::string field_name_;
@@ -77,6 +420,11 @@ public:
         [[maybe_unused]] runtime::Context& context) override {
         return {};
     }
+    void ShareFieldChains([[maybe_unused]] FieldChains& chains) override {
+    }
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
 };
 
 // Команда print
@@ -93,23 +441,96 @@ public:
     // Во время выполнения команды print вывод должен осуществляться в поток, возвращаемый из
     // context.GetOutputStream()
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+
+    // Выводит в out значение object так же, как команда print
+    static void PrintValue(const runtime::ObjectHolder& object, std::ostream& out,
+        runtime::Context& context);
 
 private:
     std::vector< std::unique_ptr<Statement>>args_;
     
 };
 
-// Вызывает метод object.method со списком параметров args
+/*
+Тело метода, которое узел MethodCall выполняет сам, не вызывая метод: чтение поля
+(def get_x(): return self.x) либо присваивание полю значения параметра
+(def set_x(value): self.x = value). Такие тела находит MethodBody::Fuse
+*/
+struct InlineMethod {
+    enum class Kind : std::uint8_t {
+        GETTER,  // возвращает значение цепочки полей path объекта self
+        SETTER,  // присваивает полю field_name объекта self значение единственного параметра
+    };
+
+    Kind kind;
+    FieldPath* path = nullptr;
+    std::string field_name;
+};
+
+class MethodBody;
+
+// Данные, которые встроенный кэш узла MethodCall запоминает вместе с найденным методом
+struct CachedMethod {
+    // Тело метода, которое место вызова выполняет само, либо nullptr
+    const InlineMethod* inline_method = nullptr;
+    // Тело метода, которое может быть транслировано в машинный код, либо nullptr
+    MethodBody* body = nullptr;
+};
+
+// Вызывает метод object.method со списком параметров args.
+// Методы, тело которых описывает InlineMethod, выполняются без вызова метода
 class MethodCall : public Statement {
 public:
     MethodCall(std::unique_ptr<Statement> object, std::string method,
         std::vector<std::unique_ptr<Statement>> args);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
+
+    // Вызывает из машинного кода метод объекта receiver с аргументами-числами args.
+    // Метод берётся только из встроенного кэша и выполняется машинным кодом (чтение поля -
+    // без вызова метода). Возвращает std::nullopt, если класса receiver нет в кэше, метод
+    // не транслируется в машинный код либо вернул не число: тогда вызывающий метод
+    // выполняется обходом AST, который и дополнит кэш
+    std::optional<std::int32_t> CallNative(runtime::ClassInstance& receiver,
+        const std::int32_t* args);
+
+    // Количество вызовов, для которых метод нашёлся во встроенном кэше узла
+    [[nodiscard]] size_t GetCacheHits() const {
+        return cache_.GetHits();
+    }
+
+    // Количество вызовов, для которых метод пришлось искать в таблице методов класса
+    [[nodiscard]] size_t GetCacheMisses() const {
+        return cache_.GetMisses();
+    }
+
 private:
+    // Выполняет тело метода inline_method для объекта instance без вызова метода
+    runtime::ObjectHolder ExecuteInline(const InlineMethod& inline_method,
+        runtime::ClassInstance& instance, runtime::Closure& closure, runtime::Context& context);
+
     std::unique_ptr<Statement> object_;
     std::string method_;
     std::vector<std::unique_ptr<Statement>> args_;
+
+    // Встроенный кэш запоминает вместе с методом описание его тела,
+    // если место вызова выполняет тело без вызова метода
+    runtime::MethodCache<CachedMethod> cache_;
 };
 
 /*
@@ -131,6 +552,13 @@ public:
     NewInstance(const runtime::Class& class_, std::vector<std::unique_ptr<Statement>> args);
     // Возвращает объект, содержащий значение типа ClassInstance
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
 
 private:
     runtime::ClassInstance class_p_;
@@ -145,6 +573,21 @@ public:
     {
     }
 
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+
+    // Возвращает аргумент операции
+    [[nodiscard]] const Statement& GetArgument() const {
+        return *argument_;
+    }
+
+    // Передаёт владение аргументом операции. Используется при упрощении узлов
+    std::unique_ptr<Statement> ReleaseArgument() {
+        return std::move(argument_);
+    }
+
 protected:
     std::unique_ptr<Statement> argument_;
 };
@@ -154,19 +597,79 @@ class Stringify : public UnaryOperation {
 public:
     using UnaryOperation::UnaryOperation;
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    std::unique_ptr<Statement> Fold() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+
+    // Возвращает строковое значение object
+    static runtime::ObjectHolder Apply(const runtime::ObjectHolder& object,
+        runtime::Context& context);
 };
 
 // Родительский класс Бинарная операция с аргументами lhs и rhs
 class BinaryOperation : public Statement {
 public:
+    /*
+    Типы аргументов, под которые специализировался узел. При первом выполнении узел запоминает
+    типы аргументов и в дальнейшем выполняет операцию для них без общей проверки типов.
+    Если типы аргументов изменились, узел переходит к общему случаю и больше не специализируется
+    */
+    enum class Specialization : std::uint8_t {
+        UNINITIALIZED,  // узел ещё не выполнялся
+        NUMBERS,        // число и число
+        STRINGS,        // строка и строка
+        INSTANCE,       // экземпляр класса запомненного класса и любой аргумент
+        GENERIC,        // общий случай
+    };
+
     BinaryOperation(std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs) 
         :lhs_(std::move(lhs))
         ,rhs_(std::move(rhs))
     {
     }
+
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+
+    // Возвращает левый аргумент операции
+    [[nodiscard]] const Statement& GetLhs() const {
+        return *lhs_;
+    }
+
+    // Передаёт владение правым аргументом операции. Используется при объединении узлов
+    std::unique_ptr<Statement> ReleaseRhs() {
+        return std::move(rhs_);
+    }
+
+    [[nodiscard]] Specialization GetSpecialization() const {
+        return specialization_;
+    }
 protected:
+    // Возвращает специализацию для значений lhs и rhs: NUMBERS, STRINGS либо GENERIC
+    static Specialization Observe(const runtime::ObjectHolder& lhs,
+        const runtime::ObjectHolder& rhs);
+
+    // Переходит к специализации observed при первом выполнении либо к общему случаю,
+    // если узел уже был специализирован под другие типы
+    void Respecialize(Specialization observed) {
+        specialization_ = specialization_ == Specialization::UNINITIALIZED
+            ? observed : Specialization::GENERIC;
+    }
+
+    // Учитывает, что оба аргумента оказались числами
+    void ObserveNumbers() {
+        if (specialization_ != Specialization::NUMBERS) {
+            Respecialize(Specialization::NUMBERS);
+        }
+    }
+
     std::unique_ptr<Statement> lhs_;
     std::unique_ptr<Statement> rhs_;
+    Specialization specialization_ = Specialization::UNINITIALIZED;
 };
 
 // Возвращает результат операции + над аргументами lhs и rhs
@@ -178,8 +681,25 @@ public:
     //  число + число
     //  строка + строка
     //  объект1 + объект2, если у объект1 - пользовательский класс с методом _add__(rhs)
-    // В противном случае при вычислении выбрасывается runtime_error
+    // В противном случае при вычислении выбрасывается runtime_error (см. runtime::Add)
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteAsInt(runtime::Closure& closure, runtime::Context& context, int& number,
+        runtime::ObjectHolder& value) override;
+    void ShareFieldChains(FieldChains& chains) override;
+
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
+
+private:
+    // Складывает вычисленные значения аргументов с учётом специализации узла
+    runtime::ObjectHolder Combine(const runtime::ObjectHolder& lhs,
+        const runtime::ObjectHolder& rhs, runtime::Context& context);
+
+    // Класс левого аргумента и его метод __add__ для специализации INSTANCE
+    const runtime::Class* instance_class_ = nullptr;
+    const runtime::Method* add_method_ = nullptr;
 };
 
 // Возвращает результат вычитания аргументов lhs и rhs
@@ -191,6 +711,13 @@ public:
     //  число - число
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteAsInt(runtime::Closure& closure, runtime::Context& context, int& number,
+        runtime::ObjectHolder& value) override;
+
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
 };
 
 // Возвращает результат умножения аргументов lhs и rhs
@@ -202,6 +729,14 @@ public:
     //  число * число
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    std::unique_ptr<Statement> Fold() override;
+    bool ExecuteAsInt(runtime::Closure& closure, runtime::Context& context, int& number,
+        runtime::ObjectHolder& value) override;
+
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
 };
 
 // Возвращает результат деления lhs и rhs
@@ -214,6 +749,13 @@ public:
     // Если lhs и rhs - не числа, выбрасывается исключение runtime_error
     // Если rhs равен 0, выбрасывается исключение runtime_error
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    bool ExecuteAsInt(runtime::Closure& closure, runtime::Context& context, int& number,
+        runtime::ObjectHolder& value) override;
+
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
 };
 
 // Возвращает результат вычисления логической операции or над lhs и rhs
@@ -223,6 +765,12 @@ public:
     // Значение аргумента rhs вычисляется, только если значение lhs
     // после приведения к Bool равно False
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    std::unique_ptr<Statement> Fold() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    bool ExecuteAsBool(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
 };
 
 // Возвращает результат вычисления логической операции and над lhs и rhs
@@ -232,6 +780,12 @@ public:
     // Значение аргумента rhs вычисляется, только если значение lhs
     // после приведения к Bool равно True
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    std::unique_ptr<Statement> Fold() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    bool ExecuteAsBool(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
 };
 
 // Возвращает результат вычисления логической операции not над единственным аргументом операции
@@ -239,6 +793,14 @@ class Not : public UnaryOperation {
 public:
     using UnaryOperation::UnaryOperation;
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    std::unique_ptr<Statement> Fold() override;
+    bool ExecuteAsBool(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+
+    // Возвращает результат операции not над значением object
+    static runtime::ObjectHolder Apply(const runtime::ObjectHolder& object);
 };
 
 // Составная инструкция (например: тело метода, содержимое ветки if, либо else)
@@ -256,9 +818,27 @@ public:
         args_.push_back(std::move(stmt));
     }
 
+    // Возвращает инструкции в порядке выполнения
+    [[nodiscard]] const std::vector<std::unique_ptr<Statement>>& GetStatements() const {
+        return args_;
+    }
+
     // Последовательно выполняет добавленные инструкции. Возвращает None
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
 
+    // Последовательно выполняет добавленные инструкции до первой выполненной инструкции return
+    runtime::Completion ExecuteStatement(runtime::Closure& closure, runtime::Context& context,
+        runtime::ObjectHolder& return_value) override;
+
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
+
 private:
     std::vector<std::unique_ptr<Statement>> args_;
 
@@ -279,8 +859,56 @@ public:
     // Если внутри body была выполнена инструкция return, возвращает результат return
     // В противном случае возвращает None
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
+    void ResolveNames(MethodScope& scope) override;
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+
+    // Назначает слоты self, параметрам formal_params и локальным переменным тела метода.
+    // Возвращает размер фрейма, который нужно передать в runtime::Method::frame_size
+    size_t ResolveFrame(const std::vector<std::string>& formal_params);
+
+    // Заменяет повторные чтения цепочек полей чтением скрытых слотов фрейма (см. FieldChains).
+    // Принимает размер фрейма, найденный ResolveFrame, и возвращает его вместе со скрытыми
+    // слотами. Выполняется после Fuse
+    size_t ShareRepeatedFieldChains(size_t frame_size);
+
+    // Возвращает true, если тело метода транслировано в машинный код
+    [[nodiscard]] bool IsNative() const {
+        return native_code_ != nullptr;
+    }
+
+    // Возвращает машинный код тела метода либо nullptr, если тело не транслируется.
+    // Тело, которое ещё не транслировалось, транслируется сразу, не дожидаясь
+    // jit::HOT_CALL_THRESHOLD вызовов: его вызывает машинный код другого метода
+    const jit::NativeCode* GetNativeCode();
+
+    // Возвращает описание тела метода, которое место вызова выполняет без вызова метода,
+    // либо nullptr. Определяется методом Fuse
+    [[nodiscard]] const InlineMethod* GetInlineMethod() const {
+        return inline_method_ ? &*inline_method_ : nullptr;
+    }
+
+    // Возвращает тело метода method, если движки vm и flat переводят его в своё представление,
+    // либо nullptr. Переводятся только тела методов, переменным которых назначены слоты
+    [[nodiscard]] static MethodBody* GetTranslatable(const runtime::Method& method);
+
+    ~MethodBody() override;
 private:
+    // Возвращает описание тела метода, если оно - чтение либо присваивание поля self
+    std::optional<InlineMethod> FindInlineMethod();
+
     std::unique_ptr<Statement> body_;
+    // Количество параметров метода, если слоты назначены методом ResolveFrame.
+    // Только такие тела методов транслируются в машинный код
+    std::optional<size_t> param_count_;
+    size_t call_count_ = 0;
+    std::unique_ptr<jit::NativeCode> native_code_;
+    std::optional<InlineMethod> inline_method_;
 };
 
 // Выполняет инструкцию return с выражением statement
@@ -291,9 +919,24 @@ public:
     {
     }
 
+    // Возвращает результат вычисления выражения statement
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+
     // Останавливает выполнение текущего метода. После выполнения инструкции return метод,
     // внутри которого она была исполнена, должен вернуть результат вычисления выражения statement.
-    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    runtime::Completion ExecuteStatement(runtime::Closure& closure, runtime::Context& context,
+        runtime::ObjectHolder& return_value) override;
+
+    void ResolveNames(MethodScope& scope) override;
+
+    // Инструкция return с переменной либо цепочкой полей заменяется узлом ReturnVariable
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
 private:
     std::unique_ptr<Statement> statement_;
 };
@@ -307,6 +950,7 @@ public:
     // Создаёт внутри closure новый объект, совпадающий с именем класса и значением, переданным в
     // конструктор
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    std::string Transpile(aot::Generator& generator) override;
 private:
     runtime::ObjectHolder cls_;
 };
@@ -319,7 +963,20 @@ public:
         std::unique_ptr<Statement> else_body);
 
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
-private:
+    runtime::Completion ExecuteStatement(runtime::Closure& closure, runtime::Context& context,
+        runtime::ObjectHolder& return_value) override;
+
+    void ResolveNames(MethodScope& scope) override;
+
+    // Инструкция if с условием-сравнением заменяется узлом CompareBranch
+    std::unique_ptr<Statement> Fold() override;
+    std::unique_ptr<Statement> Fuse() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
+protected:
     std::unique_ptr<Statement> condition_;
     std::unique_ptr<Statement> if_body_;
     std::unique_ptr<Statement> else_body_;
@@ -328,17 +985,127 @@ private:
 // Операция сравнения
 class Comparison : public BinaryOperation {
 public:
-    // Comparator задаёт функцию, выполняющую сравнение значений аргументов
-    using Comparator = std::function<bool(const runtime::ObjectHolder&,
-        const runtime::ObjectHolder&, runtime::Context&)>;
+    // Comparator задаёт функцию, выполняющую сравнение значений аргументов.
+    // Для сравнений из runtime узел вызывает функцию напрямую, без косвенного вызова
+    using Comparator = bool (*)(const runtime::ObjectHolder&, const runtime::ObjectHolder&,
+        runtime::Context&);
 
     Comparison(Comparator cmp, std::unique_ptr<Statement> lhs, std::unique_ptr<Statement> rhs);
 
     // Вычисляет значение выражений lhs и rhs и возвращает результат работы comparator,
     // приведённый к типу runtime::Bool
     runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    std::unique_ptr<Statement> Fold() override;
+    void ShareFieldChains(FieldChains& chains) override;
+    bool ExecuteAsBool(runtime::Closure& closure, runtime::Context& context) override {
+        return Test(closure, context);
+    }
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
+
+    // Сравнивает вычисленные значения аргументов
+    runtime::ObjectHolder Apply(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs,
+        runtime::Context& context) const;
+
+    // Вычисляет значения выражений lhs и rhs и возвращает результат сравнения без создания
+    // объекта runtime::Bool
+    bool Test(runtime::Closure& closure, runtime::Context& context);
 private:
+    // Операция сравнения, которую выполняет comparator. Для сравнений из runtime
+    // (runtime::Less, runtime::Equal и т.д.) узел может специализироваться под числа и строки
+    enum class Operator : std::uint8_t {
+        LESS,
+        GREATER,
+        EQUAL,
+        NOT_EQUAL,
+        LESS_OR_EQUAL,
+        GREATER_OR_EQUAL,
+        OTHER,  // произвольная функция сравнения, узел не специализируется
+    };
+
+    static Operator IdentifyOperator(const Comparator& cmp);
+
+    template <typename T>
+    [[nodiscard]] bool Compare(const T& lhs, const T& rhs) const;
+
+    // Сравнивает значения аргументов функцией сравнения из runtime, соответствующей operator_
+    bool Dispatch(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs,
+        runtime::Context& context) const;
+
+    // Сравнивает значения аргументов, используя сравнение чисел и строк без вызова
+    // функции сравнения, если аргументы - два числа либо две строки
+    bool CompareValues(const runtime::ObjectHolder& lhs, const runtime::ObjectHolder& rhs,
+        runtime::Context& context) const;
+
     Comparator comp_;
+    Operator operator_;
+};
+
+/*
+Суперинструкции - узлы, которыми Fuse заменяет часто встречающиеся сочетания узлов.
+Суперинструкция выполняет те же действия в том же порядке, что и заменённые узлы,
+но без промежуточных вызовов Execute и временных объектов
+*/
+
+// Присваивание object.field_name = object.field_name + increment.
+// Объект вычисляется один раз, слот поля запоминается для объектов одной формы
+class FieldIncrement : public Statement {
+public:
+    FieldIncrement(VariableValue object, std::string field_name,
+        std::unique_ptr<Statement> increment);
+
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+private:
+    VariableValue object_;
+    std::string field_name_;
+    std::unique_ptr<Statement> increment_;
+    const runtime::Shape* shape_ = nullptr;
+    size_t slot_ = 0;
+};
+
+// Инструкция if, условием которой служит сравнение.
+// Результат сравнения проверяется сразу, без создания объекта runtime::Bool
+class CompareBranch : public IfElse {
+public:
+    CompareBranch(std::unique_ptr<Comparison> condition, std::unique_ptr<Statement> if_body,
+        std::unique_ptr<Statement> else_body);
+
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    runtime::Completion ExecuteStatement(runtime::Closure& closure, runtime::Context& context,
+        runtime::ObjectHolder& return_value) override;
+    std::unique_ptr<Statement> Fuse() override {
+        return nullptr;
+    }
+private:
+    Comparison* comparison_;
+};
+
+// Инструкция return, возвращающая значение переменной либо цепочки полей (return self.value)
+class ReturnVariable : public Statement {
+public:
+    explicit ReturnVariable(VariableValue variable);
+
+    runtime::ObjectHolder Execute(runtime::Closure& closure, runtime::Context& context) override;
+    runtime::Completion ExecuteStatement(runtime::Closure& closure, runtime::Context& context,
+        runtime::ObjectHolder& return_value) override;
+    void ShareFieldChains(FieldChains& chains) override;
+    void Compile(vm::Compiler& compiler) override;
+    std::string Transpile(aot::Generator& generator) override;
+    std::uint32_t Flatten(flat::Builder& builder) override;
+    jit::ValueType EmitNative(jit::Emitter& emitter) override;
+
+    // Возвращает выражение, значение которого возвращает инструкция
+    VariableValue& GetVariable() {
+        return variable_;
+    }
+
+private:
+    VariableValue variable_;
 };
 
 }  // namespace ast
\ No newline at end of file
@@ -15,7 +15,7 @@ template <typename T>
 void AssertObjectValueEqual(const ObjectHolder& obj, const T& expected, const string& msg) {
     ostringstream one;
     runtime::DummyContext context;
-    obj->Print(one, context);
+    runtime::PrintValue(obj, one, context);
 
     ostringstream two;
     two << expected;
@@ -309,6 +309,43 @@ void TestCompound() {
     ASSERT(context.output.str().empty());
 }
 
+void TestReturn() {
+    runtime::DummyContext context;
+
+    auto make_body = [] {
+        auto if_body = make_unique<Compound>();
+        if_body->AddStatement(make_unique<Return>(make_unique<StringConst>("early"s)));
+        if_body->AddStatement(Print::Variable("x"s));
+
+        auto body = make_unique<Compound>();
+        body->AddStatement(make_unique<IfElse>(make_unique<VariableValue>("x"s),
+                                               std::move(if_body), nullptr));
+        body->AddStatement(Print::Variable("x"s));
+        body->AddStatement(make_unique<Return>(make_unique<NumericConst>(1)));
+        body->AddStatement(Print::Variable("x"s));
+        return MethodBody(std::move(body));
+    };
+
+    // return внутри if прекращает выполнение всего тела метода
+    {
+        Closure closure = {{"x"s, ObjectHolder::True()}};
+        auto body = make_body();
+        ASSERT_OBJECT_VALUE_EQUAL(body.Execute(closure, context), "early"s);
+        ASSERT(context.output.str().empty());
+    }
+    {
+        Closure closure = {{"x"s, ObjectHolder::False()}};
+        auto body = make_body();
+        ASSERT_OBJECT_VALUE_EQUAL(body.Execute(closure, context), 1);
+        ASSERT_EQUAL(context.output.str(), "False\n"s);
+    }
+
+    // Тело метода без return возвращает None
+    Closure closure;
+    MethodBody empty(make_unique<Compound>());
+    ASSERT(!empty.Execute(closure, context));
+}
+
 void TestFields() {
     runtime::DummyContext context;
 
@@ -345,6 +382,77 @@ void TestFields() {
     ASSERT(context.output.str().empty());
 }
 
+void TestFieldChain() {
+    runtime::DummyContext context;
+    runtime::Class cls("Node"s, {}, nullptr);
+
+    runtime::ClassInstance inner(cls);
+    inner.SetField("x"s, ObjectHolder::Own(runtime::Number(1)));
+    runtime::ClassInstance outer(cls);
+    outer.SetField("inner"s, ObjectHolder::Share(inner));
+
+    Closure closure = {{"outer"s, ObjectHolder::Share(outer)}};
+    VariableValue chain(vector{"outer"s, "inner"s, "x"s});
+    ASSERT_OBJECT_VALUE_EQUAL(chain.Execute(closure, context), 1);
+
+    // Значение поля читается заново при каждом вычислении
+    inner.SetField("x"s, ObjectHolder::Own(runtime::Number(2)));
+    ASSERT_OBJECT_VALUE_EQUAL(chain.Execute(closure, context), 2);
+
+    // Объект другой формы с тем же полем в другом слоте
+    runtime::ClassInstance other(cls);
+    other.SetField("y"s, ObjectHolder::None());
+    other.SetField("x"s, ObjectHolder::Own(runtime::Number(3)));
+    outer.SetField("inner"s, ObjectHolder::Share(other));
+    ASSERT_OBJECT_VALUE_EQUAL(chain.Execute(closure, context), 3);
+
+    // Объект, поля которого хранятся в Closure
+    other.Fields()["x"s] = ObjectHolder::Own(runtime::Number(4));
+    ASSERT_OBJECT_VALUE_EQUAL(chain.Execute(closure, context), 4);
+
+    outer.SetField("inner"s, ObjectHolder::Share(outer));
+    ASSERT_THROWS(chain.Execute(closure, context), runtime_error);
+}
+
+void TestFrameSlots() {
+    runtime::DummyContext context;
+
+    // def inc(x):
+    //   y = x + 1
+    //   return y
+    auto inc_body = make_unique<MethodBody>(make_unique<Compound>(
+        make_unique<Assignment>("y"s, make_unique<Add>(make_unique<VariableValue>("x"s),
+                                                       make_unique<NumericConst>(1))),
+        make_unique<Return>(make_unique<VariableValue>("y"s))));
+    const size_t inc_frame_size = inc_body->ResolveFrame({"x"s});
+    ASSERT_EQUAL(inc_frame_size, 3U);
+
+    // def pick(c):
+    //   if c:
+    //     t = self
+    //   return t
+    auto pick_body = make_unique<MethodBody>(make_unique<Compound>(
+        make_unique<IfElse>(make_unique<VariableValue>("c"s),
+                            make_unique<Assignment>("t"s, make_unique<VariableValue>("self"s)),
+                            nullptr),
+        make_unique<Return>(make_unique<VariableValue>("t"s))));
+    const size_t pick_frame_size = pick_body->ResolveFrame({"c"s});
+    ASSERT_EQUAL(pick_frame_size, 3U);
+
+    vector<runtime::Method> methods;
+    methods.push_back({"inc"s, {"x"s}, std::move(inc_body), inc_frame_size});
+    methods.push_back({"pick"s, {"c"s}, std::move(pick_body), pick_frame_size});
+    runtime::Class cls("Frames"s, std::move(methods), nullptr);
+    runtime::ClassInstance inst(cls);
+
+    ASSERT_OBJECT_VALUE_EQUAL(inst.Call("inc"s, {ObjectHolder::Own(runtime::Number(41))}, context),
+                              42);
+    ASSERT_EQUAL(inst.Call("pick"s, {ObjectHolder::True()}, context).Get(), &inst);
+    // Локальная переменная, которой не присвоено значение, остаётся неизвестной
+    ASSERT_THROWS(inst.Call("pick"s, {ObjectHolder::False()}, context), runtime_error);
+    ASSERT(context.GetFrame() == nullptr);
+}
+
 void TestBaseClass() {
     vector<runtime::Method> methods;
     methods.push_back({"GetValue"s, {}, make_unique<VariableValue>(vector{"self"s, "value"s})});
@@ -408,6 +516,443 @@ void TestInheritance() {
     ASSERT(!cls.GetMethod("AsStringValue"s));
 }
 
+void TestMethodCallCache() {
+    runtime::DummyContext context;
+
+    vector<runtime::Method> base_methods;
+    base_methods.push_back({"GetValue"s, {}, make_unique<NumericConst>(1)});
+    runtime::Class base("Base"s, std::move(base_methods), nullptr);
+
+    vector<runtime::Method> derived_methods;
+    derived_methods.push_back({"GetValue"s, {}, make_unique<NumericConst>(2)});
+    runtime::Class derived("Derived"s, std::move(derived_methods), &base);
+
+    runtime::ClassInstance base_inst(base);
+    runtime::ClassInstance derived_inst(derived);
+
+    Closure closure = {{"obj"s, ObjectHolder::Share(base_inst)}};
+    MethodCall call(make_unique<VariableValue>("obj"s), "GetValue"s, {});
+
+    // Мономорфный вызов: метод ищется в классе только в первый раз
+    for (int i = 0; i < 3; ++i) {
+        ASSERT_OBJECT_VALUE_EQUAL(call.Execute(closure, context), 1);
+    }
+    ASSERT_EQUAL(call.GetCacheMisses(), 1U);
+    ASSERT_EQUAL(call.GetCacheHits(), 2U);
+
+    // Полиморфный вызов: кэш хранит методы обоих классов
+    closure["obj"s] = ObjectHolder::Share(derived_inst);
+    ASSERT_OBJECT_VALUE_EQUAL(call.Execute(closure, context), 2);
+    closure["obj"s] = ObjectHolder::Share(base_inst);
+    ASSERT_OBJECT_VALUE_EQUAL(call.Execute(closure, context), 1);
+    closure["obj"s] = ObjectHolder::Share(derived_inst);
+    ASSERT_OBJECT_VALUE_EQUAL(call.Execute(closure, context), 2);
+    ASSERT_EQUAL(call.GetCacheMisses(), 2U);
+    ASSERT_EQUAL(call.GetCacheHits(), 4U);
+
+    // Отсутствующий метод в кэш не попадает
+    MethodCall missing(make_unique<VariableValue>("obj"s), "Missing"s, {});
+    ASSERT_THROWS(missing.Execute(closure, context), runtime_error);
+    ASSERT_THROWS(missing.Execute(closure, context), runtime_error);
+    ASSERT_EQUAL(missing.GetCacheHits(), 0U);
+}
+
+void TestInlineMethods() {
+    runtime::DummyContext context;
+    // Создаёт метод, тело которого разобрано так же, как при разборе программы
+    auto make_method = [](string name, vector<string> params, unique_ptr<Statement> statement) {
+        auto body = make_unique<MethodBody>(make_unique<Compound>(std::move(statement)));
+        runtime::Method method{std::move(name), std::move(params), nullptr};
+        method.frame_size = body->ResolveFrame(method.formal_params);
+        body->Fuse();
+        method.body = std::move(body);
+        return method;
+    };
+    auto inline_method = [](const runtime::Class& cls, const string& name, size_t count) {
+        return static_cast<const MethodBody&>(*cls.GetMethod(name, count)->body).GetInlineMethod();
+    };
+
+    vector<runtime::Method> base_methods;
+    base_methods.push_back(make_method(
+        "get_x"s, {}, make_unique<Return>(make_unique<VariableValue>(vector{"self"s, "x"s}))));
+    base_methods.push_back(make_method(
+        "set_x"s, {"v"s},
+        make_unique<FieldAssignment>(VariableValue("self"s), "x"s, make_unique<VariableValue>("v"s))));
+    base_methods.push_back(make_method("show"s, {}, Print::Variable("self"s)));
+    runtime::Class base("Base"s, std::move(base_methods), nullptr);
+
+    vector<runtime::Method> derived_methods;
+    derived_methods.push_back(
+        make_method("get_x"s, {}, make_unique<Return>(make_unique<NumericConst>(5))));
+    runtime::Class derived("Derived"s, std::move(derived_methods), &base);
+
+    ASSERT(inline_method(base, "get_x"s, 0)->kind == InlineMethod::Kind::GETTER);
+    ASSERT(inline_method(base, "set_x"s, 1)->kind == InlineMethod::Kind::SETTER);
+    ASSERT(inline_method(base, "show"s, 0) == nullptr);
+    ASSERT(inline_method(derived, "get_x"s, 0) == nullptr);
+
+    runtime::ClassInstance base_inst(base);
+    runtime::ClassInstance derived_inst(derived);
+    Closure closure = {{"obj"s, ObjectHolder::Share(base_inst)}};
+    MethodCall get(make_unique<VariableValue>("obj"s), "get_x"s, {});
+    vector<unique_ptr<Statement>> args;
+    args.push_back(make_unique<NumericConst>(3));
+    MethodCall set(make_unique<VariableValue>("obj"s), "set_x"s, std::move(args));
+
+    // Поля ещё нет: ошибка та же, что при вызове метода
+    ASSERT_THROWS(get.Execute(closure, context), runtime_error);
+    ASSERT(!set.Execute(closure, context));
+    ASSERT_OBJECT_VALUE_EQUAL(get.Execute(closure, context), 3);
+
+    // Класс-наследник переопределяет get_x и наследует set_x
+    closure["obj"s] = ObjectHolder::Share(derived_inst);
+    set.Execute(closure, context);
+    ASSERT_OBJECT_VALUE_EQUAL(*derived_inst.FindField("x"s), 3);
+    ASSERT_OBJECT_VALUE_EQUAL(get.Execute(closure, context), 5);
+    closure["obj"s] = ObjectHolder::Share(base_inst);
+    ASSERT_OBJECT_VALUE_EQUAL(get.Execute(closure, context), 3);
+}
+
+void TestSharedFieldChains() {
+    runtime::DummyContext context;
+    auto field = [](vector<string> names) {
+        return make_unique<VariableValue>(std::move(names));
+    };
+
+    // a = self.p.q.x
+    // b = self.p.q.x + a
+    // self.p.q = self.r
+    // c = self.p.q.x
+    // self.p.q.y = 1
+    // d = self.p.q.x
+    // print a, b, c, d
+    vector<unique_ptr<Statement>> args;
+    args.push_back(make_unique<VariableValue>("a"s));
+    args.push_back(make_unique<VariableValue>("b"s));
+    args.push_back(make_unique<VariableValue>("c"s));
+    args.push_back(make_unique<VariableValue>("d"s));
+    auto body = make_unique<MethodBody>(make_unique<Compound>(
+        make_unique<Assignment>("a"s, field({"self"s, "p"s, "q"s, "x"s})),
+        make_unique<Assignment>("b"s, make_unique<Add>(field({"self"s, "p"s, "q"s, "x"s}),
+                                                       make_unique<VariableValue>("a"s))),
+        make_unique<FieldAssignment>(VariableValue(vector{"self"s, "p"s}), "q"s,
+                                     field({"self"s, "r"s})),
+        make_unique<Assignment>("c"s, field({"self"s, "p"s, "q"s, "x"s})),
+        make_unique<FieldAssignment>(VariableValue(vector{"self"s, "p"s, "q"s}), "y"s,
+                                     make_unique<NumericConst>(1)),
+        make_unique<Assignment>("d"s, field({"self"s, "p"s, "q"s, "x"s})),
+        make_unique<Print>(std::move(args))));
+    runtime::Method method{"run"s, {}, nullptr};
+    method.frame_size = body->ResolveFrame(method.formal_params);
+    body->Fuse();
+    ASSERT_EQUAL(method.frame_size, 5U);
+
+    // Цепочка читается повторно до присваивания self.p.q и после него:
+    // каждому участку нужен свой скрытый слот
+    method.frame_size = body->ShareRepeatedFieldChains(method.frame_size);
+    ASSERT_EQUAL(method.frame_size, 7U);
+    method.body = std::move(body);
+
+    vector<runtime::Method> methods;
+    methods.push_back(std::move(method));
+    runtime::Class cls("Node"s, std::move(methods), nullptr);
+    runtime::ClassInstance root(cls);
+    runtime::ClassInstance p(cls);
+    runtime::ClassInstance q(cls);
+    runtime::ClassInstance r(cls);
+    q.SetField("x"s, ObjectHolder::Own(runtime::Number(1)));
+    r.SetField("x"s, ObjectHolder::Own(runtime::Number(10)));
+    p.SetField("q"s, ObjectHolder::Share(q));
+    root.SetField("p"s, ObjectHolder::Share(p));
+    root.SetField("r"s, ObjectHolder::Share(r));
+
+    root.Call(*cls.GetMethod("run"s), {}, context);
+    ASSERT_EQUAL(context.output.str(), "1 2 10 10\n"s);
+    ASSERT_OBJECT_VALUE_EQUAL(*r.FindField("y"s), 1);
+}
+
+void TestSuperinstructions() {
+    runtime::DummyContext context;
+    runtime::Class cls("Counter"s, {}, nullptr);
+    runtime::ClassInstance counter(cls);
+    counter.SetField("value"s, ObjectHolder::Own(runtime::Number(1)));
+    Closure closure = {{"c"s, ObjectHolder::Share(counter)},
+                       {"n"s, ObjectHolder::Own(runtime::Number(2))}};
+
+    // c.value = c.value + n
+    unique_ptr<Statement> increment = make_unique<FieldAssignment>(
+        VariableValue{"c"s}, "value"s,
+        make_unique<Add>(make_unique<VariableValue>(vector{"c"s, "value"s}),
+                         make_unique<VariableValue>("n"s)));
+    FuseNode(increment);
+    ASSERT(dynamic_cast<FieldIncrement*>(increment.get()));
+    ASSERT_OBJECT_VALUE_EQUAL(increment->Execute(closure, context), 3);
+    ASSERT_OBJECT_VALUE_EQUAL(increment->Execute(closure, context), 5);
+    ASSERT_OBJECT_VALUE_EQUAL(*counter.FindField("value"s), 5);
+
+    // Объект, поля которого хранятся в Closure
+    counter.Fields()["value"s] = ObjectHolder::Own(runtime::Number(5));
+    ASSERT_OBJECT_VALUE_EQUAL(increment->Execute(closure, context), 7);
+    ASSERT_OBJECT_VALUE_EQUAL(*counter.FindField("value"s), 7);
+
+    // Присваивание другому полю не объединяется
+    unique_ptr<Statement> copy = make_unique<FieldAssignment>(
+        VariableValue{"c"s}, "other"s,
+        make_unique<Add>(make_unique<VariableValue>(vector{"c"s, "value"s}),
+                         make_unique<VariableValue>("n"s)));
+    FuseNode(copy);
+    ASSERT(dynamic_cast<FieldAssignment*>(copy.get()));
+
+    // Ошибки те же, что и у исходных узлов
+    unique_ptr<Statement> bad_object = make_unique<FieldAssignment>(
+        VariableValue{"n"s}, "value"s,
+        make_unique<Add>(make_unique<VariableValue>(vector{"n"s, "value"s}),
+                         make_unique<NumericConst>(1)));
+    FuseNode(bad_object);
+    ASSERT_THROWS(bad_object->Execute(closure, context), runtime_error);
+    unique_ptr<Statement> bad_field = make_unique<FieldAssignment>(
+        VariableValue{"c"s}, "missing"s,
+        make_unique<Add>(make_unique<VariableValue>(vector{"c"s, "missing"s}),
+                         make_unique<NumericConst>(1)));
+    FuseNode(bad_field);
+    ASSERT_THROWS(bad_field->Execute(closure, context), runtime_error);
+
+    // if c.value < n: print 'less' else: print 'not less'
+    unique_ptr<Statement> branch = make_unique<IfElse>(
+        make_unique<Comparison>(runtime::Less, make_unique<VariableValue>(vector{"c"s, "value"s}),
+                                make_unique<VariableValue>("n"s)),
+        make_unique<Print>(make_unique<StringConst>("less"s)),
+        make_unique<Print>(make_unique<StringConst>("not less"s)));
+    FuseNode(branch);
+    ASSERT(dynamic_cast<CompareBranch*>(branch.get()));
+    branch->Execute(closure, context);
+    closure["n"s] = ObjectHolder::Own(runtime::Number(10));
+    branch->Execute(closure, context);
+    ASSERT_EQUAL(context.output.str(), "not less\nless\n"s);
+
+    // return c.value
+    unique_ptr<Statement> return_field
+        = make_unique<Return>(make_unique<VariableValue>(vector{"c"s, "value"s}));
+    FuseNode(return_field);
+    ASSERT(dynamic_cast<ReturnVariable*>(return_field.get()));
+    ObjectHolder result;
+    ASSERT(return_field->ExecuteStatement(closure, context, result) == runtime::Completion::RETURN);
+    ASSERT_OBJECT_VALUE_EQUAL(result, 7);
+}
+
+void TestSpecialization() {
+    using Specialization = BinaryOperation::Specialization;
+    runtime::DummyContext context;
+    Closure closure = {{"x"s, ObjectHolder::Own(runtime::Number(7))},
+                       {"y"s, ObjectHolder::Own(runtime::Number(2))}};
+
+    Add add(make_unique<VariableValue>("x"s), make_unique<VariableValue>("y"s));
+    Div div(make_unique<VariableValue>("x"s), make_unique<VariableValue>("y"s));
+    Comparison less(runtime::Less, make_unique<VariableValue>("x"s),
+                    make_unique<VariableValue>("y"s));
+    ASSERT(add.GetSpecialization() == Specialization::UNINITIALIZED);
+
+    ASSERT_OBJECT_VALUE_EQUAL(add.Execute(closure, context), 9);
+    ASSERT_OBJECT_VALUE_EQUAL(div.Execute(closure, context), 3);
+    ASSERT_OBJECT_VALUE_EQUAL(less.Execute(closure, context), "False"s);
+    ASSERT(add.GetSpecialization() == Specialization::NUMBERS);
+    ASSERT(div.GetSpecialization() == Specialization::NUMBERS);
+    ASSERT(less.GetSpecialization() == Specialization::NUMBERS);
+
+    // Специализированный узел проверяет ошибки так же, как общий
+    closure["y"s] = ObjectHolder::Own(runtime::Number(0));
+    ASSERT_THROWS(div.Execute(closure, context), runtime_error);
+    ASSERT(div.GetSpecialization() == Specialization::NUMBERS);
+
+    // При смене типов аргументов узел переходит к общему случаю
+    closure["x"s] = ObjectHolder::Own(runtime::String("a"s));
+    closure["y"s] = ObjectHolder::Own(runtime::String("b"s));
+    ASSERT_OBJECT_VALUE_EQUAL(add.Execute(closure, context), "ab"s);
+    ASSERT_OBJECT_VALUE_EQUAL(less.Execute(closure, context), "True"s);
+    ASSERT_THROWS(div.Execute(closure, context), runtime_error);
+    ASSERT(add.GetSpecialization() == Specialization::GENERIC);
+    ASSERT(div.GetSpecialization() == Specialization::GENERIC);
+    ASSERT(less.GetSpecialization() == Specialization::GENERIC);
+    closure["y"s] = ObjectHolder::Own(runtime::Number(1));
+    ASSERT_THROWS(add.Execute(closure, context), runtime_error);
+
+    // Сложение объектов специализируется под класс левого аргумента
+    vector<runtime::Method> methods;
+    methods.push_back({"__add__"s, {"rhs"s}, make_unique<VariableValue>("rhs"s)});
+    runtime::Class cls("Left"s, std::move(methods), nullptr);
+    runtime::Class other_cls("Other"s, {}, nullptr);
+    runtime::ClassInstance instance(cls);
+    runtime::ClassInstance other(other_cls);
+    closure["x"s] = ObjectHolder::Share(instance);
+    Add instance_add(make_unique<VariableValue>("x"s), make_unique<VariableValue>("y"s));
+    ASSERT_OBJECT_VALUE_EQUAL(instance_add.Execute(closure, context), 1);
+    ASSERT(instance_add.GetSpecialization() == Specialization::INSTANCE);
+    closure["x"s] = ObjectHolder::Share(other);
+    ASSERT_THROWS(instance_add.Execute(closure, context), runtime_error);
+    ASSERT(instance_add.GetSpecialization() == Specialization::GENERIC);
+
+    // Узел с произвольной функцией сравнения не специализируется
+    Comparison custom(
+        [](const ObjectHolder& lhs, const ObjectHolder& rhs, runtime::Context&) {
+            return lhs.TryAs<runtime::Number>()->GetValue() % 2
+                   == rhs.TryAs<runtime::Number>()->GetValue() % 2;
+        },
+        make_unique<NumericConst>(3), make_unique<NumericConst>(5));
+    ASSERT_OBJECT_VALUE_EQUAL(custom.Execute(closure, context), "True"s);
+    ASSERT(custom.GetSpecialization() == Specialization::GENERIC);
+}
+
+void TestComparisonOperators() {
+    runtime::DummyContext context;
+    Closure closure;
+    using Comparator = Comparison::Comparator;
+    const Comparator comparators[] = {runtime::Less,        runtime::Greater,
+                                      runtime::Equal,       runtime::NotEqual,
+                                      runtime::LessOrEqual, runtime::GreaterOrEqual};
+    const pair<ObjectHolder, ObjectHolder> operands[] = {
+        {ObjectHolder::Own(runtime::Number(1)), ObjectHolder::Own(runtime::Number(2))},
+        {ObjectHolder::Own(runtime::Number(2)), ObjectHolder::Own(runtime::Number(2))},
+        {ObjectHolder::Own(runtime::String("b"s)), ObjectHolder::Own(runtime::String("a"s))},
+        {ObjectHolder::Own(runtime::Bool(false)), ObjectHolder::Own(runtime::Bool(true))},
+        {ObjectHolder::None(), ObjectHolder::None()},
+    };
+
+    // Результат узла совпадает с результатом функции сравнения из runtime
+    for (Comparator comparator : comparators) {
+        for (const auto& [lhs, rhs] : operands) {
+            bool expected = false;
+            bool failed = false;
+            try {
+                expected = comparator(lhs, rhs, context);
+            } catch (const runtime_error&) {
+                failed = true;
+            }
+            closure["l"s] = lhs;
+            closure["r"s] = rhs;
+            Comparison comparison(comparator, make_unique<VariableValue>("l"s),
+                                  make_unique<VariableValue>("r"s));
+            if (failed) {
+                ASSERT_THROWS(comparison.Execute(closure, context), runtime_error);
+                ASSERT_THROWS(comparison.Apply(lhs, rhs, context), runtime_error);
+            }
+            else {
+                ASSERT_EQUAL(comparison.ExecuteAsBool(closure, context), expected);
+                ASSERT_EQUAL(runtime::IsTrue(comparison.Apply(lhs, rhs, context)), expected);
+            }
+        }
+    }
+}
+
+void TestUnboxedEvaluation() {
+    runtime::DummyContext context;
+    Closure closure = {{"x"s, ObjectHolder::Own(runtime::Number(7))},
+                       {"s"s, ObjectHolder::Own(runtime::String("a"s))}};
+
+    // x * 3 + 20 / x
+    Add sum(make_unique<Mult>(make_unique<VariableValue>("x"s), make_unique<NumericConst>(3)),
+            make_unique<Div>(make_unique<NumericConst>(20), make_unique<VariableValue>("x"s)));
+    int number = 0;
+    ObjectHolder value;
+    ASSERT(sum.ExecuteAsInt(closure, context, number, value));
+    ASSERT_EQUAL(number, 23);
+    ASSERT(!value);
+    ASSERT_OBJECT_VALUE_EQUAL(sum.Execute(closure, context), 23);
+
+    // Значение другого типа возвращается в value
+    Add concat(make_unique<VariableValue>("s"s), make_unique<StringConst>("b"s));
+    ASSERT(!concat.ExecuteAsInt(closure, context, number, value));
+    ASSERT_OBJECT_VALUE_EQUAL(value, "ab"s);
+    Div by_zero(make_unique<VariableValue>("x"s), make_unique<NumericConst>(0));
+    ASSERT_THROWS(by_zero.ExecuteAsInt(closure, context, number, value), runtime_error);
+
+    // Условия вычисляются без создания объектов Bool
+    Comparison less(runtime::Less, make_unique<VariableValue>("x"s),
+                    make_unique<NumericConst>(10));
+    ASSERT(less.ExecuteAsBool(closure, context));
+    Not not_less(make_unique<Comparison>(runtime::Less, make_unique<VariableValue>("x"s),
+                                         make_unique<NumericConst>(10)));
+    ASSERT(!not_less.ExecuteAsBool(closure, context));
+    Or either(make_unique<NumericConst>(0), make_unique<VariableValue>("s"s));
+    ASSERT(either.ExecuteAsBool(closure, context));
+    And both(make_unique<BoolConst>(runtime::Bool(true)), make_unique<StringConst>(""s));
+    ASSERT(!both.ExecuteAsBool(closure, context));
+    ASSERT_OBJECT_VALUE_EQUAL(both.Execute(closure, context), "False"s);
+
+    // Условием может быть значение любого типа
+    IfElse branch(make_unique<VariableValue>("x"s), make_unique<Assignment>("r"s,
+                  make_unique<NumericConst>(1)), nullptr);
+    branch.Execute(closure, context);
+    ASSERT_OBJECT_VALUE_EQUAL(closure.at("r"s), 1);
+}
+
+void TestConstantFolding() {
+    runtime::DummyContext context;
+    Closure closure = {{"x"s, ObjectHolder::Own(runtime::Number(7))}};
+    auto folded_value = [&](unique_ptr<Statement> node) {
+        FoldNode(node);
+        ASSERT(dynamic_cast<NumericConst*>(node.get()) || dynamic_cast<StringConst*>(node.get())
+               || dynamic_cast<BoolConst*>(node.get()));
+        return node->Execute(closure, context);
+    };
+
+    // -8 и 60 * 60 * 24
+    ASSERT_OBJECT_VALUE_EQUAL(
+        folded_value(make_unique<Mult>(make_unique<NumericConst>(8), make_unique<NumericConst>(-1))),
+        -8);
+    ASSERT_OBJECT_VALUE_EQUAL(
+        folded_value(make_unique<Mult>(
+            make_unique<Mult>(make_unique<NumericConst>(60), make_unique<NumericConst>(60)),
+            make_unique<NumericConst>(24))),
+        86400);
+    ASSERT_OBJECT_VALUE_EQUAL(
+        folded_value(make_unique<Add>(make_unique<StringConst>("a"s),
+                                      make_unique<Stringify>(make_unique<NumericConst>(1)))),
+        "a1"s);
+    ASSERT_OBJECT_VALUE_EQUAL(
+        folded_value(make_unique<Or>(make_unique<Comparison>(runtime::Less,
+                                                             make_unique<NumericConst>(1),
+                                                             make_unique<NumericConst>(2)),
+                                     make_unique<VariableValue>("x"s))),
+        "True"s);
+
+    // Ошибка вычисления остаётся до выполнения программы
+    unique_ptr<Statement> by_zero
+        = make_unique<Div>(make_unique<NumericConst>(1), make_unique<NumericConst>(0));
+    FoldNode(by_zero);
+    ASSERT(dynamic_cast<Div*>(by_zero.get()));
+
+    // not not (x < 10) заменяется сравнением, x * 1 при нечисловом x сохраняется
+    unique_ptr<Statement> double_not = make_unique<Not>(make_unique<Not>(
+        make_unique<Comparison>(runtime::Less, make_unique<VariableValue>("x"s),
+                                make_unique<NumericConst>(10))));
+    FoldNode(double_not);
+    ASSERT(dynamic_cast<Comparison*>(double_not.get()));
+    unique_ptr<Statement> times_one
+        = make_unique<Mult>(make_unique<VariableValue>("x"s), make_unique<NumericConst>(1));
+    FoldNode(times_one);
+    ASSERT(dynamic_cast<Mult*>(times_one.get()));
+    times_one = make_unique<Mult>(
+        make_unique<Sub>(make_unique<VariableValue>("x"s), make_unique<NumericConst>(1)),
+        make_unique<NumericConst>(1));
+    FoldNode(times_one);
+    ASSERT(dynamic_cast<Sub*>(times_one.get()));
+
+    // Ветка с константным условием заменяет инструкцию if
+    unique_ptr<Statement> branch = make_unique<IfElse>(
+        make_unique<Not>(make_unique<BoolConst>(runtime::Bool(true))),
+        make_unique<Assignment>("r"s, make_unique<NumericConst>(1)),
+        make_unique<Assignment>("r"s, make_unique<NumericConst>(2)));
+    FoldNode(branch);
+    ASSERT(dynamic_cast<Assignment*>(branch.get()));
+    branch->Execute(closure, context);
+    ASSERT_OBJECT_VALUE_EQUAL(closure.at("r"s), 2);
+    branch = make_unique<IfElse>(make_unique<NumericConst>(0),
+                                 make_unique<Assignment>("r"s, make_unique<NumericConst>(1)),
+                                 nullptr);
+    FoldNode(branch);
+    ASSERT(dynamic_cast<Compound*>(branch.get()));
+}
+
 void TestOr() {
     auto test_or = [](bool lhs, bool rhs) {
         Or or_statement{make_unique<BoolConst>(lhs), make_unique<BoolConst>(rhs)};
@@ -471,9 +1016,20 @@ void RunUnitTests(TestRunner& tr) {
     RUN_TEST(tr, ast::TestSuccessfulClassInstanceAdd);
     RUN_TEST(tr, ast::TestClassInstanceAddWithoutMethod);
     RUN_TEST(tr, ast::TestCompound);
+    RUN_TEST(tr, ast::TestReturn);
     RUN_TEST(tr, ast::TestFields);
+    RUN_TEST(tr, ast::TestFieldChain);
+    RUN_TEST(tr, ast::TestFrameSlots);
     RUN_TEST(tr, ast::TestBaseClass);
     RUN_TEST(tr, ast::TestInheritance);
+    RUN_TEST(tr, ast::TestMethodCallCache);
+    RUN_TEST(tr, ast::TestInlineMethods);
+    RUN_TEST(tr, ast::TestSharedFieldChains);
+    RUN_TEST(tr, ast::TestSuperinstructions);
+    RUN_TEST(tr, ast::TestSpecialization);
+    RUN_TEST(tr, ast::TestComparisonOperators);
+    RUN_TEST(tr, ast::TestUnboxedEvaluation);
+    RUN_TEST(tr, ast::TestConstantFolding);
     RUN_TEST(tr, ast::TestOr);
     RUN_TEST(tr, ast::TestAnd);
     RUN_TEST(tr, ast::TestNot);
@@ -0,0 +1,444 @@
+#pragma once
+
+/*
+ * Программы на Mython с ожидаемым выводом, общие для тестов. Тесты разбора выполняют их обходом
+ * AST, тесты движков vm и flat сравнивают вывод движка с выводом обхода AST, тест aot - вывод
+ * оттранслированной в C++ и собранной программы
+ */
+
+#include "lexer.h"
+#include "parse.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <test_runner.h>
+
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace test_programs {
+
+using namespace std::literals;
+
+struct TestProgram {
+    // Имя теста без префикса Test
+    std::string name;
+    std::string text;
+    // Вывод программы. Сообщение об ошибке выполнения следует за выводом после "error: "
+    std::string expected;
+};
+
+// Программы тестов разбора и выполнения обходом AST
+inline const std::vector<TestProgram>& ParsePrograms() {
+    static const std::vector<TestProgram> programs = {
+        {
+            "SimpleProgram"s,
+            R"(
+x = 4
+y = 5
+z = "hello, "
+n = "world"
+print x + y, z + n
+)"s,
+            "9 hello, world\n"s,
+        },
+        {
+            "ProgramWithClasses"s,
+            R"(
+program_name = "Classes test"
+
+class Empty:
+  def __init__():
+    x = 0
+
+class Point:
+  def __init__(x, y):
+    self.x = x
+    self.y = y
+
+  def SetX(value):
+    self.x = value
+  def SetY(value):
+    self.y = value
+
+  def __str__():
+    return '(' + str(self.x) + '; ' + str(self.y) + ')'
+
+origin = Empty()
+origin = Point(0, 0)
+
+far_far_away = Point(10000, 50000)
+
+print program_name, origin, far_far_away, origin.SetX(1)
+)"s,
+            "Classes test (0; 0) (10000; 50000) None\n"s,
+        },
+        {
+            "ProgramWithIf"s,
+            R"(
+x = 4
+y = 5
+if x > y:
+  print "x > y"
+else:
+  print "x <= y"
+if x > 0:
+  if y < 0:
+    print "y < 0"
+  else:
+    print "y >= 0"
+else:
+  print 'x <= 0'
+)"s,
+            "x <= y\ny >= 0\n"s,
+        },
+        {
+            "ReturnFromIf"s,
+            R"(
+class Abs:
+  def calc(n):
+    if n > 0:
+      return n
+    else:
+      return -n
+
+x = Abs()
+print x.calc(2)
+)"s,
+            "2\n"s,
+        },
+        {
+            "Recursion"s,
+            R"(
+class ArithmeticProgression:
+  def calc(n):
+    self.result = 0
+    self.calc_impl(n)
+
+  def calc_impl(n):
+    value = n
+    if value > 0:
+      self.result = self.result + value
+      self.calc_impl(value - 1)
+
+x = ArithmeticProgression()
+x.calc(10)
+print x.result
+)"s,
+            "55\n"s,
+        },
+        {
+            "Recursion2"s,
+            R"(
+class GCD:
+  def __init__():
+    self.call_count = 0
+
+  def calc(a, b):
+    self.call_count = self.call_count + 1
+    if a < b:
+      return self.calc(b, a)
+    if b == 0:
+      return a
+    return self.calc(a - b, b)
+
+x = GCD()
+print x.calc(510510, 18629977)
+print x.calc(22, 17)
+print x.call_count
+)"s,
+            "17\n1\n115\n"s,
+        },
+        {
+            "ComplexLogicalExpression"s,
+            R"(
+a = 1
+b = 2
+c = 3
+ok = a + b > c and a + c > b and b + c > a
+print ok
+)"s,
+            "False\n"s,
+        },
+        {
+            "ClassicalPolymorphism"s,
+            R"(
+class Shape:
+  def __str__():
+    return "Shape"
+
+class Rect(Shape):
+  def __init__(w, h):
+    self.w = w
+    self.h = h
+
+  def __str__():
+    return "Rect(" + str(self.w) + 'x' + str(self.h) + ')'
+
+class Circle(Shape):
+  def __init__(r):
+    self.r = r
+
+  def __str__():
+    return 'Circle(' + str(self.r) + ')'
+
+class Triangle(Shape):
+  def __init__(a, b, c):
+    self.ok = a + b > c and a + c > b and b + c > a
+    if (self.ok):
+      self.a = a
+      self.b = b
+      self.c = c
+
+  def __str__():
+    if self.ok:
+      return 'Triangle(' + str(self.a) + ', ' + str(self.b) + ', ' + str(self.c) + ')'
+    else:
+      return 'Wrong triangle'
+
+r = Rect(10, 20)
+c = Circle(52)
+t1 = Triangle(3, 4, 5)
+t2 = Triangle(125, 1, 2)
+
+print r, c, t1, t2
+)"s,
+            "Rect(10x20) Circle(52) Triangle(3, 4, 5) Wrong triangle\n"s,
+        },
+    };
+    return programs;
+}
+
+// Программы, на которых движки сравниваются с обходом AST
+inline const std::vector<TestProgram>& EnginePrograms() {
+    static const std::vector<TestProgram> programs = {
+        {
+            "Expressions"s,
+            R"(
+x = 4
+y = 5
+z = "hello, "
+print x + y, z + "world", x * y - 1, y / 2, -x
+print x < y, x == y, x >= y, "a" < "b", None
+print x > 0 and y > 0, x < 0 or y < 0, not x, not not y
+print str(x) + str(None), True, 1 + 2 * 3
+)"s,
+            "9 hello, world 19 2 -4\nTrue False False True None\n"
+            "True False False True\n4None True 7\n"s,
+        },
+        {
+            "ShortCircuit"s,
+            R"(
+class Logger:
+  def log(text, value):
+    print text
+    return value
+
+l = Logger()
+print l.log('a', 0) and l.log('b', 1)
+print l.log('c', 1) or l.log('d', 1)
+print l.log('e', 1) and l.log('f', 0)
+print l.log('g', '') or l.log('h', 'x')
+)"s,
+            "a\nFalse\nc\nTrue\ne\nf\nFalse\ng\nh\nTrue\n"s,
+        },
+        {
+            "Methods"s,
+            R"(
+class Counter:
+  def __init__(start):
+    self.value = start
+
+  def add(n):
+    self.value = self.value + n
+    return self
+
+  def fact(n):
+    if n < 2:
+      return 1
+    return n * self.fact(n - 1)
+
+  def __str__():
+    return 'Counter(' + str(self.value) + ')'
+
+  def __add__(other):
+    return self.value + other.value
+
+  def __eq__(other):
+    return self.value == other.value
+
+  def __lt__(other):
+    return self.value < other.value
+
+class Named(Counter):
+  def __init__(name):
+    self.name = name
+    self.value = 0
+
+  def __str__():
+    return self.name + ':' + str(self.value)
+
+c = Counter(1)
+c.add(2)
+c.add(3)
+n = Named('n')
+n.add(10)
+print c, n, c + n, c.fact(10)
+print c == n, c < n, c > n, c <= n, c != n
+d = Counter(5)
+print d.value
+)"s,
+            "Counter(6) n:10 16 3628800\n"
+            "False True False True True\n5\n"s,
+        },
+        {
+            "ControlFlow"s,
+            R"(
+class Abs:
+  def calc(n):
+    if n > 0:
+      return n
+    else:
+      return -n
+    print 'unreachable'
+
+  def sign(n):
+    if n > 0:
+      result = 1
+    else:
+      if n < 0:
+        result = -1
+      else:
+        result = 0
+    return result
+
+x = Abs()
+print x.calc(2), x.calc(-3), x.sign(-7), x.sign(0), x.sign(4)
+if x.calc(-1) == 1:
+  print 'yes'
+else:
+  print 'no'
+)"s,
+            "2 3 -1 0 1\nyes\n"s,
+        },
+        {
+            "LargeNumbers"s,
+            R"(
+class Box:
+  def __init__():
+    self.value = 100000
+
+  def grow(n):
+    self.value = self.value + n * 1000
+    return self.value
+
+b = Box()
+x = b.grow(2000) + 2000000000
+b.value = x - 1
+print x, b.value, b.value / 1000, -b.value
+)"s,
+            "2002100000 2002099999 2002099 -2002099999\n"s,
+        },
+        // Программы с ошибками выполнения: вывод, сделанный до ошибки, и сообщение об ошибке
+        // совпадают
+        {
+            "UnknownVariable"s,
+            "print 1, x\n"s,
+            "1 error: Unknown variable name"s,
+        },
+        {
+            "MethodNotFound"s,
+            R"(
+class A:
+  def f():
+    return 1
+
+a = A()
+print a.g(), 2
+)"s,
+            "error: Method not found"s,
+        },
+        {
+            "UnassignedLocal"s,
+            R"(
+class A:
+  def f(c):
+    if c:
+      t = 1
+    return t
+
+a = A()
+print a.f(True)
+print a.f(False)
+)"s,
+            "1\nerror: Unknown variable name"s,
+        },
+        {
+            "FieldOfNonInstance"s,
+            "x = 1\nx.y = 2\n"s,
+            "error: Object must be a ClassInstance to assign a field"s,
+        },
+        {
+            "DivisionByZero"s,
+            "print 1 / 0\n"s,
+            "error: Failed to divide by 0, can't deal with eternity"s,
+        },
+        {
+            "MissingMethodArguments"s,
+            R"(
+class A:
+  def log(text):
+    print text
+
+a = A()
+print a.g(a.log('arg')), 2
+)"s,
+            "arg\nerror: Method not found"s,
+        },
+    };
+    return programs;
+}
+
+// Способ выполнения дерева программы
+using Engine = void (*)(ast::Statement& program, runtime::Closure& closure,
+    runtime::Context& context);
+
+// Выполняет программу обходом AST
+inline void ExecuteTree(ast::Statement& program, runtime::Closure& closure,
+    runtime::Context& context) {
+    program.Execute(closure, context);
+}
+
+// Выполняет программу text способом engine и возвращает её вывод.
+// Сообщение об ошибке выполнения добавляется в конец вывода после "error: "
+inline std::string RunProgram(const std::string& text, Engine engine = ExecuteTree) {
+    std::istringstream is(text);
+    parse::Lexer lexer(is);
+    auto tree = ParseProgram(lexer);
+
+    runtime::DummyContext context;
+    try {
+        runtime::Closure closure;
+        engine(*tree, closure, context);
+    } catch (const std::runtime_error& e) {
+        context.output << "error: "s << e.what();
+    }
+    return context.output.str();
+}
+
+// Добавляет тесты, которые выполняют программы EnginePrograms обходом AST и способом engine
+// и сравнивают вывод с ожидаемым. Имена тестов начинаются с prefix
+inline void RunEngineTests(TestRunner& tr, const std::string& prefix, Engine engine) {
+    for (const TestProgram& program : EnginePrograms()) {
+        tr.RunTest(
+            [&program, engine] {
+                ASSERT_EQUAL(RunProgram(program.text), program.expected);
+                ASSERT_EQUAL(RunProgram(program.text, engine), program.expected);
+            },
+            prefix + "::Test"s + program.name);
+    }
+}
+
+}  // namespace test_programs
@@ -79,6 +79,13 @@ inline void Assert(bool b, const std::string& hint) {
     AssertEqual(b, true, hint);
 }
 
+// Исключение, которым тест сообщает, что он пропущен: такой тест не считается
+// ни успешным, ни проваленным
+class TestSkipped : public std::runtime_error {
+public:
+    using std::runtime_error::runtime_error;
+};
+
 class TestRunner {
 public:
     template <class TestFunc>
@@ -86,6 +93,8 @@ public:
         try {
             func();
             std::cerr << test_name << " OK" << std::endl;
+        } catch (TestSkipped& e) {
+            std::cerr << test_name << " skipped: " << e.what() << std::endl;
         } catch (std::exception& e) {
             ++fail_count;
             std::cerr << test_name << " fail: " << e.what() << std::endl;
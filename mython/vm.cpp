@@ -0,0 +1,521 @@
+#include "vm.h"
+
+#include <cassert>
+#include <stdexcept>
+
+using namespace std;
+
+namespace vm {
+
+using runtime::Append;
+using runtime::Closure;
+using runtime::Context;
+using runtime::ObjectHolder;
+
+namespace {
+
+// Сообщения об ошибках инструкции EXPECT_INSTANCE
+enum ExpectInstanceMessage : std::uint32_t {
+    FIELD_ASSIGNMENT_TARGET,
+    METHOD_CALL_TARGET,
+};
+
+const string EXPECT_INSTANCE_MESSAGES[] = {
+    "Object must be a ClassInstance to assign a field"s,
+    "Object must be a ClassInstance to call a method"s,
+};
+
+// Начальный размер стека значений
+constexpr size_t INITIAL_STACK_CAPACITY = 256;
+
+// Возвращает стек значений к размеру, который он имел при создании объекта
+class StackRestorer {
+public:
+    explicit StackRestorer(vector<ObjectHolder>& stack)
+        : stack_(stack)
+        , size_(stack.size()) {
+    }
+
+    StackRestorer(const StackRestorer&) = delete;
+    StackRestorer& operator=(const StackRestorer&) = delete;
+
+    ~StackRestorer() {
+        stack_.resize(size_);
+    }
+
+private:
+    vector<ObjectHolder>& stack_;
+    size_t size_;
+};
+
+}  // namespace
+
+void Compiler::CompileStatement(ast::Statement& node) {
+    CompileExpression(node);
+    Emit(OpCode::POP);
+}
+
+size_t Compiler::Emit(OpCode op, std::uint32_t operand) {
+    auto& code = chunk_.code;
+    // Значение константы, которое сразу снимается со стека, не вычисляется вовсе.
+    // Если на следующую инструкцию указывает переход, удалять константу нельзя
+    if (op == OpCode::POP && !code.empty() && last_jump_target_ < code.size()
+        && (code.back().op == OpCode::PUSH_NONE || code.back().op == OpCode::PUSH_CONST)) {
+        code.pop_back();
+        return code.size();
+    }
+    code.push_back({ op, operand });
+    return code.size() - 1;
+}
+
+void Compiler::PatchJump(size_t jump) {
+    chunk_.code[jump].operand = GetPosition();
+    last_jump_target_ = chunk_.code.size();
+}
+
+std::uint32_t Compiler::AddConstant(ObjectHolder value) {
+    return Append(chunk_.constants, std::move(value));
+}
+
+std::uint32_t Compiler::AddName(const string& name) {
+    return Append(chunk_.names, name);
+}
+
+std::uint32_t Compiler::AddFieldPath(const ast::FieldPath& path) {
+    return Append(chunk_.field_paths, path);
+}
+
+std::uint32_t Compiler::AddComparison(const ast::Comparison& comparison) {
+    return Append(chunk_.comparisons, &comparison);
+}
+
+std::uint32_t Compiler::AddCallSite(const string& method, size_t argument_count) {
+    CallSite site;
+    site.method = method;
+    site.argument_count = static_cast<std::uint32_t>(argument_count);
+    return Append(chunk_.call_sites, std::move(site));
+}
+
+std::uint32_t Compiler::AddNewInstance(runtime::ClassInstance& instance, size_t argument_count) {
+    NewInstanceSite site;
+    site.instance = &instance;
+    site.argument_count = static_cast<std::uint32_t>(argument_count);
+    return Append(chunk_.new_instances, site);
+}
+
+std::uint32_t Compiler::AddNode(ast::Statement& node) {
+    return Append(chunk_.nodes, &node);
+}
+
+Program::Program(ast::Statement& program) {
+    Compiler compiler(main_);
+    compiler.CompileStatement(program);
+    compiler.Emit(OpCode::PUSH_NONE);
+    compiler.Emit(OpCode::RETURN);
+    stack_.reserve(INITIAL_STACK_CAPACITY);
+}
+
+void Program::Execute(Closure& closure, Context& context) {
+    Run(main_, closure, context.GetFrame(), context);
+}
+
+Chunk* Program::GetMethodCode(const runtime::Method& method) {
+    auto [it, inserted] = methods_.emplace(&method, nullptr);
+    if (inserted) {
+        if (auto* body = ast::MethodBody::GetTranslatable(method)) {
+            auto code = make_unique<Chunk>();
+            Compiler compiler(*code);
+            compiler.CompileExpression(*body);
+            it->second = std::move(code);
+        }
+    }
+    return it->second.get();
+}
+
+ObjectHolder Program::Invoke(runtime::ClassInstance& instance, const runtime::Method& method,
+    Chunk* code, size_t argument_count, Context& context) {
+    runtime::StackFrame frame(context.GetFrameStack(),
+        runtime::ClassInstance::GetFrameSize(method));
+    const size_t first_argument = stack_.size() - argument_count;
+    for (size_t i = 0; i < argument_count; ++i) {
+        frame[i + 1] = std::move(stack_[first_argument + i]);
+    }
+    if (!code) {
+        return instance.CallInFrame(method, frame.Get(), context);
+    }
+    frame[0] = ObjectHolder::Share(instance);
+    runtime::FrameScope frame_scope(context, frame.Get());
+    Closure closure;
+    return Run(*code, closure, frame.Get(), context);
+}
+
+ObjectHolder Program::Run(Chunk& chunk, Closure& closure, runtime::FrameSlot* frame,
+    Context& context) {
+    StackRestorer stack_restorer(stack_);
+    // Снимает значение с вершины стека
+    auto pop = [this] {
+        ObjectHolder value = std::move(stack_.back());
+        stack_.pop_back();
+        return value;
+    };
+
+    const Instruction* code = chunk.code.data();
+    size_t pc = 0;
+    for (;;) {
+        const Instruction instruction = code[pc++];
+        const std::uint32_t operand = instruction.operand;
+        switch (instruction.op) {
+        case OpCode::PUSH_CONST:
+            stack_.push_back(chunk.constants[operand]);
+            break;
+        case OpCode::PUSH_NONE:
+            stack_.emplace_back();
+            break;
+        case OpCode::POP:
+            stack_.pop_back();
+            break;
+        case OpCode::DUP:
+            stack_.push_back(stack_.back());
+            break;
+        case OpCode::LOAD_LOCAL: {
+            const runtime::FrameSlot& variable = frame[operand];
+            if (!variable) {
+                throw runtime_error("Unknown variable name"s);
+            }
+            stack_.push_back(*variable);
+            break;
+        }
+        case OpCode::STORE_LOCAL:
+            frame[operand] = stack_.back();
+            break;
+        case OpCode::LOAD_NAME: {
+            auto it = closure.find(chunk.names[operand]);
+            if (it == closure.end()) {
+                throw runtime_error("Unknown variable name"s);
+            }
+            stack_.push_back(it->second);
+            break;
+        }
+        case OpCode::STORE_NAME:
+            closure[chunk.names[operand]] = stack_.back();
+            break;
+        case OpCode::LOAD_FIELDS: {
+            ObjectHolder value = chunk.field_paths[operand].Resolve(stack_.back());
+            stack_.back() = std::move(value);
+            break;
+        }
+        case OpCode::EXPECT_INSTANCE:
+            if (stack_.back().GetKind() != runtime::ObjectKind::CLASS_INSTANCE) {
+                throw runtime_error(EXPECT_INSTANCE_MESSAGES[operand]);
+            }
+            break;
+        case OpCode::STORE_FIELD: {
+            ObjectHolder value = pop();
+            ObjectHolder object = pop();
+            stack_.push_back(object.As<runtime::ClassInstance>().SetField(chunk.names[operand],
+                std::move(value)));
+            break;
+        }
+        case OpCode::ADD: {
+            ObjectHolder rhs = pop();
+            ObjectHolder lhs = pop();
+            stack_.push_back(runtime::Add(lhs, rhs, context));
+            break;
+        }
+        case OpCode::SUB: {
+            ObjectHolder rhs = pop();
+            ObjectHolder lhs = pop();
+            stack_.push_back(runtime::Sub(lhs, rhs, context));
+            break;
+        }
+        case OpCode::MULT: {
+            ObjectHolder rhs = pop();
+            ObjectHolder lhs = pop();
+            stack_.push_back(runtime::Mult(lhs, rhs, context));
+            break;
+        }
+        case OpCode::DIV: {
+            ObjectHolder rhs = pop();
+            ObjectHolder lhs = pop();
+            stack_.push_back(runtime::Div(lhs, rhs, context));
+            break;
+        }
+        case OpCode::COMPARE: {
+            ObjectHolder rhs = pop();
+            ObjectHolder lhs = pop();
+            stack_.push_back(chunk.comparisons[operand]->Apply(lhs, rhs, context));
+            break;
+        }
+        case OpCode::NOT: {
+            ObjectHolder value = pop();
+            stack_.push_back(ast::Not::Apply(value));
+            break;
+        }
+        case OpCode::STRINGIFY: {
+            ObjectHolder value = pop();
+            stack_.push_back(ast::Stringify::Apply(value, context));
+            break;
+        }
+        case OpCode::JUMP:
+            pc = operand;
+            break;
+        case OpCode::JUMP_IF_FALSE:
+            if (!runtime::IsTrue(pop())) {
+                pc = operand;
+            }
+            break;
+        case OpCode::JUMP_IF_TRUE:
+            if (runtime::IsTrue(pop())) {
+                pc = operand;
+            }
+            break;
+        case OpCode::PRINT_SPACE:
+            context.GetOutputStream() << ' ';
+            break;
+        case OpCode::PRINT_VALUE: {
+            ObjectHolder value = pop();
+            ast::Print::PrintValue(value, context.GetOutputStream(), context);
+            break;
+        }
+        case OpCode::PRINT_NEWLINE:
+            context.GetOutputStream() << '\n';
+            break;
+        case OpCode::CALL_METHOD: {
+            CallSite& site = chunk.call_sites[operand];
+            const size_t argument_count = site.argument_count;
+            auto& instance
+                = stack_[stack_.size() - argument_count - 1].As<runtime::ClassInstance>();
+            const auto entry = site.Find(instance.GetClass(), [this](const runtime::Method& method) {
+                return GetMethodCode(method);
+            });
+            if (!entry.method) {
+                throw runtime_error("Method not found"s);
+            }
+
+            ObjectHolder result = Invoke(instance, *entry.method, entry.data, argument_count,
+                context);
+            stack_.resize(stack_.size() - argument_count - 1);
+            stack_.push_back(std::move(result));
+            break;
+        }
+        case OpCode::NEW_INSTANCE: {
+            const NewInstanceSite& site = chunk.new_instances[operand];
+            if (!site.FindInit()) {
+                stack_.push_back(ObjectHolder::Share(*site.instance));
+                pc = site.end;
+            }
+            break;
+        }
+        case OpCode::INIT_INSTANCE: {
+            const NewInstanceSite& site = chunk.new_instances[operand];
+            const runtime::Method* init = site.FindInit();
+            assert(init != nullptr);
+            Invoke(*site.instance, *init, GetMethodCode(*init), site.argument_count, context);
+            stack_.resize(stack_.size() - site.argument_count);
+            stack_.push_back(ObjectHolder::Share(*site.instance));
+            break;
+        }
+        case OpCode::RETURN:
+            return pop();
+        case OpCode::EXECUTE:
+            stack_.push_back(chunk.nodes[operand]->Execute(closure, context));
+            break;
+        }
+    }
+}
+
+}  // namespace vm
+
+// Трансляция узлов AST в байт-код
+
+namespace ast {
+
+using vm::OpCode;
+
+void Statement::Compile(vm::Compiler& compiler) {
+    compiler.Emit(OpCode::EXECUTE, compiler.AddNode(*this));
+}
+
+void CompileConstant(vm::Compiler& compiler, runtime::ObjectHolder value) {
+    compiler.Emit(OpCode::PUSH_CONST, compiler.AddConstant(std::move(value)));
+}
+
+void None::Compile(vm::Compiler& compiler) {
+    compiler.Emit(OpCode::PUSH_NONE);
+}
+
+void VariableValue::Compile(vm::Compiler& compiler) {
+    if (slot_ != MethodScope::NO_SLOT) {
+        compiler.Emit(OpCode::LOAD_LOCAL, static_cast<std::uint32_t>(slot_));
+    }
+    else {
+        compiler.Emit(OpCode::LOAD_NAME, compiler.AddName(var_name_));
+    }
+    if (!field_path_.IsEmpty()) {
+        compiler.Emit(OpCode::LOAD_FIELDS, compiler.AddFieldPath(field_path_));
+    }
+}
+
+void Assignment::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*rv_);
+    if (slot_ != MethodScope::NO_SLOT) {
+        compiler.Emit(OpCode::STORE_LOCAL, static_cast<std::uint32_t>(slot_));
+    }
+    else {
+        compiler.Emit(OpCode::STORE_NAME, compiler.AddName(var_));
+    }
+}
+
+void FieldAssignment::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(object_);
+    compiler.Emit(OpCode::EXPECT_INSTANCE, vm::FIELD_ASSIGNMENT_TARGET);
+    compiler.CompileExpression(*rv_);
+    compiler.Emit(OpCode::STORE_FIELD, compiler.AddName(field_name_));
+}
+
+void Print::Compile(vm::Compiler& compiler) {
+    for (size_t i = 0; i < args_.size(); ++i) {
+        if (i > 0) {
+            compiler.Emit(OpCode::PRINT_SPACE);
+        }
+        compiler.CompileExpression(*args_[i]);
+        compiler.Emit(OpCode::PRINT_VALUE);
+    }
+    compiler.Emit(OpCode::PRINT_NEWLINE);
+    compiler.Emit(OpCode::PUSH_NONE);
+}
+
+void MethodCall::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*object_);
+    compiler.Emit(OpCode::EXPECT_INSTANCE, vm::METHOD_CALL_TARGET);
+    for (auto& arg : args_) {
+        compiler.CompileExpression(*arg);
+    }
+    compiler.Emit(OpCode::CALL_METHOD, compiler.AddCallSite(method_, args_.size()));
+}
+
+void NewInstance::Compile(vm::Compiler& compiler) {
+    const std::uint32_t site = compiler.AddNewInstance(class_p_, args_.size());
+    compiler.Emit(OpCode::NEW_INSTANCE, site);
+    for (auto& arg : args_) {
+        compiler.CompileExpression(*arg);
+    }
+    compiler.Emit(OpCode::INIT_INSTANCE, site);
+    compiler.GetNewInstance(site).end = compiler.GetPosition();
+}
+
+void Stringify::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*argument_);
+    compiler.Emit(OpCode::STRINGIFY);
+}
+
+void Not::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*argument_);
+    compiler.Emit(OpCode::NOT);
+}
+
+void Add::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*lhs_);
+    compiler.CompileExpression(*rhs_);
+    compiler.Emit(OpCode::ADD);
+}
+
+void Sub::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*lhs_);
+    compiler.CompileExpression(*rhs_);
+    compiler.Emit(OpCode::SUB);
+}
+
+void Mult::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*lhs_);
+    compiler.CompileExpression(*rhs_);
+    compiler.Emit(OpCode::MULT);
+}
+
+void Div::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*lhs_);
+    compiler.CompileExpression(*rhs_);
+    compiler.Emit(OpCode::DIV);
+}
+
+void Comparison::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*lhs_);
+    compiler.CompileExpression(*rhs_);
+    compiler.Emit(OpCode::COMPARE, compiler.AddComparison(*this));
+}
+
+void Or::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*lhs_);
+    const size_t lhs_true = compiler.Emit(OpCode::JUMP_IF_TRUE);
+    compiler.CompileExpression(*rhs_);
+    const size_t rhs_true = compiler.Emit(OpCode::JUMP_IF_TRUE);
+    CompileConstant(compiler, runtime::ObjectHolder::False());
+    const size_t end = compiler.Emit(OpCode::JUMP);
+    compiler.PatchJump(lhs_true);
+    compiler.PatchJump(rhs_true);
+    CompileConstant(compiler, runtime::ObjectHolder::True());
+    compiler.PatchJump(end);
+}
+
+void And::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*lhs_);
+    const size_t lhs_false = compiler.Emit(OpCode::JUMP_IF_FALSE);
+    compiler.CompileExpression(*rhs_);
+    const size_t rhs_false = compiler.Emit(OpCode::JUMP_IF_FALSE);
+    CompileConstant(compiler, runtime::ObjectHolder::True());
+    const size_t end = compiler.Emit(OpCode::JUMP);
+    compiler.PatchJump(lhs_false);
+    compiler.PatchJump(rhs_false);
+    CompileConstant(compiler, runtime::ObjectHolder::False());
+    compiler.PatchJump(end);
+}
+
+void Compound::Compile(vm::Compiler& compiler) {
+    for (auto& argument : args_) {
+        compiler.CompileStatement(*argument);
+    }
+    compiler.Emit(OpCode::PUSH_NONE);
+}
+
+void Return::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*statement_);
+    compiler.Emit(OpCode::RETURN);
+}
+
+void IfElse::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(*condition_);
+    const size_t else_branch = compiler.Emit(OpCode::JUMP_IF_FALSE);
+    compiler.CompileExpression(*if_body_);
+    const size_t end = compiler.Emit(OpCode::JUMP);
+    compiler.PatchJump(else_branch);
+    if (else_body_) {
+        compiler.CompileExpression(*else_body_);
+    }
+    else {
+        compiler.Emit(OpCode::PUSH_NONE);
+    }
+    compiler.PatchJump(end);
+}
+
+void FieldIncrement::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(object_);
+    compiler.Emit(OpCode::EXPECT_INSTANCE, vm::FIELD_ASSIGNMENT_TARGET);
+    compiler.Emit(OpCode::DUP);
+    compiler.Emit(OpCode::LOAD_FIELDS, compiler.AddFieldPath(FieldPath({ field_name_ })));
+    compiler.CompileExpression(*increment_);
+    compiler.Emit(OpCode::ADD);
+    compiler.Emit(OpCode::STORE_FIELD, compiler.AddName(field_name_));
+}
+
+void ReturnVariable::Compile(vm::Compiler& compiler) {
+    compiler.CompileExpression(variable_);
+    compiler.Emit(OpCode::RETURN);
+}
+
+void MethodBody::Compile(vm::Compiler& compiler) {
+    compiler.CompileStatement(*body_);
+    compiler.Emit(OpCode::PUSH_NONE);
+    compiler.Emit(OpCode::RETURN);
+}
+
+}  // namespace ast
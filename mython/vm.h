@@ -0,0 +1,151 @@
+#pragma once
+
+#include "call_site.h"
+#include "runtime.h"
+#include "statement.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace vm {
+
+// Код операции байт-кода. Операции работают со стеком значений
+enum class OpCode : std::uint8_t {
+    PUSH_CONST,       // помещает на стек константу с номером operand
+    PUSH_NONE,        // помещает на стек None
+    POP,              // снимает значение с вершины стека
+    DUP,              // помещает на стек копию значения с вершины стека
+    LOAD_LOCAL,       // помещает на стек значение слота operand фрейма метода
+    STORE_LOCAL,      // записывает вершину стека в слот operand фрейма метода
+    LOAD_NAME,        // помещает на стек значение переменной с именем operand из closure
+    STORE_NAME,       // записывает вершину стека в переменную с именем operand в closure
+    LOAD_FIELDS,      // заменяет вершину стека значением цепочки полей operand
+    EXPECT_INSTANCE,  // проверяет, что на вершине стека экземпляр класса (operand - сообщение)
+    STORE_FIELD,      // [объект, значение] -> значение, присвоенное полю с именем operand
+    ADD,              // [lhs, rhs] -> lhs + rhs
+    SUB,              // [lhs, rhs] -> lhs - rhs
+    MULT,             // [lhs, rhs] -> lhs * rhs
+    DIV,              // [lhs, rhs] -> lhs / rhs
+    COMPARE,          // [lhs, rhs] -> результат сравнения operand
+    NOT,              // заменяет вершину стека результатом операции not
+    STRINGIFY,        // заменяет вершину стека результатом операции str
+    JUMP,             // переходит к инструкции operand
+    JUMP_IF_FALSE,    // снимает значение со стека и переходит к operand, если оно ложно
+    JUMP_IF_TRUE,     // снимает значение со стека и переходит к operand, если оно истинно
+    PRINT_SPACE,      // выводит пробел, разделяющий значения команды print
+    PRINT_VALUE,      // снимает значение со стека и выводит его
+    PRINT_NEWLINE,    // выводит перевод строки, завершающий команду print
+    CALL_METHOD,      // [объект, аргументы...] -> результат вызова метода operand
+    NEW_INSTANCE,     // начинает создание объекта operand; если __init__ нет, пропускает аргументы
+    INIT_INSTANCE,    // [аргументы...] -> объект operand после вызова __init__
+    RETURN,           // завершает выполнение кода, возвращая вершину стека
+    EXECUTE,          // помещает на стек результат Execute узла AST с номером operand
+};
+
+struct Instruction {
+    OpCode op;
+    std::uint32_t operand = 0;
+};
+
+struct Chunk;
+
+// Место вызова метода. Кэш запоминает вместе с методом его байт-код
+// (nullptr, если тело метода выполняется обходом AST)
+using CallSite = runtime::CallSite<Chunk*>;
+
+// Место создания объекта инструкцией NEW_INSTANCE
+struct NewInstanceSite : runtime::NewInstanceSite {
+    // Инструкция, следующая за вычислением аргументов __init__
+    std::uint32_t end = 0;
+};
+
+// Байт-код программы либо тела метода вместе с используемыми им данными
+struct Chunk {
+    std::vector<Instruction> code;
+    std::vector<runtime::ObjectHolder> constants;
+    std::vector<std::string> names;
+    std::vector<ast::FieldPath> field_paths;
+    std::vector<const ast::Comparison*> comparisons;
+    std::vector<CallSite> call_sites;
+    std::vector<NewInstanceSite> new_instances;
+    std::vector<ast::Statement*> nodes;
+};
+
+// Транслирует узлы AST в байт-код chunk. Узлы AST должны существовать, пока используется chunk
+class Compiler {
+public:
+    explicit Compiler(Chunk& chunk)
+        : chunk_(chunk) {
+    }
+
+    // Добавляет код, оставляющий значение node на вершине стека
+    void CompileExpression(ast::Statement& node) {
+        node.Compile(*this);
+    }
+
+    // Добавляет код, выполняющий node без сохранения значения
+    void CompileStatement(ast::Statement& node);
+
+    // Добавляет инструкцию и возвращает её номер
+    size_t Emit(OpCode op, std::uint32_t operand = 0);
+
+    // Направляет инструкцию перехода с номером jump на следующую добавляемую инструкцию
+    void PatchJump(size_t jump);
+
+    // Номер следующей добавляемой инструкции
+    [[nodiscard]] std::uint32_t GetPosition() const {
+        return static_cast<std::uint32_t>(chunk_.code.size());
+    }
+
+    std::uint32_t AddConstant(runtime::ObjectHolder value);
+    std::uint32_t AddName(const std::string& name);
+    std::uint32_t AddFieldPath(const ast::FieldPath& path);
+    std::uint32_t AddComparison(const ast::Comparison& comparison);
+    std::uint32_t AddCallSite(const std::string& method, size_t argument_count);
+    std::uint32_t AddNewInstance(runtime::ClassInstance& instance, size_t argument_count);
+    std::uint32_t AddNode(ast::Statement& node);
+
+    // Возвращает место создания объекта с номером index
+    NewInstanceSite& GetNewInstance(std::uint32_t index) {
+        return chunk_.new_instances[index];
+    }
+
+private:
+    Chunk& chunk_;
+    // Номер инструкции, на которую указывает последний добавленный переход
+    size_t last_jump_target_ = 0;
+};
+
+/*
+ * Программа на Mython, переведённая в байт-код, и стековая виртуальная машина для её выполнения.
+ * Тела методов переводятся в байт-код при первом вызове из байт-кода. Методы, вызванные
+ * средой выполнения (например, __str__ при выводе объекта), выполняются обходом AST.
+ * AST программы должно существовать, пока существует Program
+ */
+class Program {
+public:
+    explicit Program(ast::Statement& program);
+
+    // Выполняет программу, используя closure для хранения переменных верхнего уровня
+    void Execute(runtime::Closure& closure, runtime::Context& context);
+
+private:
+    runtime::ObjectHolder Run(Chunk& chunk, runtime::Closure& closure, runtime::FrameSlot* frame,
+        runtime::Context& context);
+
+    // Вызывает метод method объекта instance с аргументами на вершине стека
+    runtime::ObjectHolder Invoke(runtime::ClassInstance& instance, const runtime::Method& method,
+        Chunk* code, size_t argument_count, runtime::Context& context);
+
+    // Возвращает байт-код метода либо nullptr, если тело метода выполняется обходом AST
+    Chunk* GetMethodCode(const runtime::Method& method);
+
+    Chunk main_;
+    std::unordered_map<const runtime::Method*, std::unique_ptr<Chunk>> methods_;
+    std::vector<runtime::ObjectHolder> stack_;
+};
+
+}  // namespace vm
@@ -0,0 +1,24 @@
+#include "test_programs.h"
+#include "vm.h"
+
+#include <test_runner.h>
+
+using namespace std;
+
+namespace vm {
+
+namespace {
+
+// Выполняет программу в виртуальной машине
+void ExecuteBytecode(ast::Statement& program, runtime::Closure& closure,
+    runtime::Context& context) {
+    Program(program).Execute(closure, context);
+}
+
+}  // namespace
+
+void RunUnitTests(TestRunner& tr) {
+    test_programs::RunEngineTests(tr, "vm"s, ExecuteBytecode);
+}
+
+}  // namespace vm